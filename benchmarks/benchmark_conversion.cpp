@@ -0,0 +1,79 @@
+/**
+ * benchmark: 	benchmark_conversion
+ * description:	Comparison between colour conversion backends: swscale (SWS_BICUBIC) and the native SIMD kernels.
+ * 				Every frame is decoded and converted, the yuv420p passthrough run is the decode only baseline:
+ * 				subtract it to get the conversion cost per frame.
+*/
+
+#include <iostream>
+#include <video_capture/video_capture.hpp>
+#include <video_capture/raw_frame.hpp>
+#include <benchmark/cppbenchmark.h>
+
+const auto video_path = "../../../../tests/data/testsrc_30sec_30fps.mkv";
+
+template<vc::conversion_backend Backend>
+class ConversionFixture : public CppBenchmark::Benchmark
+{
+public:
+    using Benchmark::Benchmark;
+
+protected:
+	vc::video_capture _vc;
+	vc::raw_frame _frame;
+
+    void Initialize(CppBenchmark::Context& context) override
+	{
+		_vc.set_output_pixel_format(static_cast<vc::pixel_format>(context.x()));
+		_vc.set_conversion_backend(Backend);
+
+		if(!_vc.open(video_path))
+		{
+			std::cout << "Unable to open " << video_path << std::endl;
+			context.Cancel();
+			return;
+		}
+
+	    _frame.data.resize(_vc.get_frame_size_in_bytes().value());
+	}
+
+    void Cleanup(CppBenchmark::Context& context) override 
+	{ 
+		_vc.release();
+	}
+
+	void Run(CppBenchmark::Context& context) override
+	{	
+		int64_t frames = 0;
+		while(_vc.read(&_frame))
+			++frames;
+
+		context.metrics().AddItems(frames);
+	}
+};
+
+using Conversion_Swscale = ConversionFixture<vc::conversion_backend::swscale>;
+using Conversion_Native = ConversionFixture<vc::conversion_backend::native>;
+
+const auto attempts = 3;
+const auto operations = 1;
+
+BENCHMARK_CLASS(Conversion_Swscale,
+	"Conversion.Passthrough.YUV420P",
+	Settings().Attempts(attempts).Operations(operations).Param(static_cast<int>(vc::pixel_format::yuv420p)))
+
+BENCHMARK_CLASS(Conversion_Swscale,
+	"Conversion.Swscale",
+	Settings().Attempts(attempts).Operations(operations)
+		.Param(static_cast<int>(vc::pixel_format::bgr24))
+		.Param(static_cast<int>(vc::pixel_format::rgb24))
+		.Param(static_cast<int>(vc::pixel_format::rgba)))
+
+BENCHMARK_CLASS(Conversion_Native,
+	"Conversion.Native",
+	Settings().Attempts(attempts).Operations(operations)
+		.Param(static_cast<int>(vc::pixel_format::bgr24))
+		.Param(static_cast<int>(vc::pixel_format::rgb24))
+		.Param(static_cast<int>(vc::pixel_format::rgba)))
+
+BENCHMARK_MAIN()
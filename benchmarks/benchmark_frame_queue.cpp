@@ -0,0 +1,110 @@
+/**
+ * benchmark: 	benchmark_frame_queue
+ * description:	Comparison between vc::frame_queue (mutex and condition variables around a std::deque) 
+ * 				and vc::spsc_queue (lock-free single producer / single consumer ring buffer).
+ * 				Throughput: one producer thread pushes a stream of items, the consumer pops them (items/s).
+ * 				Latency: one item bounces between two threads through a pair of queues (ns per round trip).
+*/
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <video_capture/frame_queue.hpp>
+#include <video_capture/spsc_queue.hpp>
+#include <benchmark/cppbenchmark.h>
+
+const auto items = 1'000'000;
+
+template<typename Queue>
+class QueueFixture_Throughput : public CppBenchmark::Benchmark
+{
+public:
+    using Benchmark::Benchmark;
+
+protected:
+	void Run(CppBenchmark::Context& context) override
+	{
+		Queue queue(static_cast<size_t>(context.x()));
+
+		std::thread producer([&queue]()
+		{
+			for (int i = 0; i < items; ++i)
+				queue.put(i);
+		});
+
+		int value = 0;
+		for (int i = 0; i < items; ++i)
+			queue.get(&value);
+
+		producer.join();
+		context.metrics().AddItems(items);
+	}
+};
+
+template<typename Queue>
+class QueueFixture_Latency : public CppBenchmark::Benchmark
+{
+public:
+    using Benchmark::Benchmark;
+
+protected:
+	std::unique_ptr<Queue> _ping;
+	std::unique_ptr<Queue> _pong;
+	std::thread _echo;
+
+    void Initialize(CppBenchmark::Context& context) override
+	{
+		_ping = std::make_unique<Queue>(1);
+		_pong = std::make_unique<Queue>(1);
+		_echo = std::thread([this]()
+		{
+			int value = 0;
+			while (true)
+			{
+				_ping->get(&value);
+				if (value < 0)
+					break;
+				_pong->put(value);
+			}
+		});
+	}
+
+    void Cleanup(CppBenchmark::Context& context) override 
+	{ 
+		_ping->put(-1);
+		_echo.join();
+	}
+
+	void Run(CppBenchmark::Context& context) override
+	{	
+		int value = 0;
+		_ping->put(1);
+		_pong->get(&value);
+	}
+};
+
+using FrameQueue_Throughput = QueueFixture_Throughput<vc::frame_queue<int>>;
+using SpscQueue_Throughput = QueueFixture_Throughput<vc::spsc_queue<int>>;
+using FrameQueue_Latency = QueueFixture_Latency<vc::frame_queue<int>>;
+using SpscQueue_Latency = QueueFixture_Latency<vc::spsc_queue<int>>;
+
+const auto attempts = 3;
+const auto round_trips = 100'000;
+
+BENCHMARK_CLASS(FrameQueue_Throughput,
+	"FrameQueue.Throughput",
+	Settings().Attempts(attempts).Operations(1).Param(1).Param(4).Param(64))
+
+BENCHMARK_CLASS(SpscQueue_Throughput,
+	"SpscQueue.Throughput",
+	Settings().Attempts(attempts).Operations(1).Param(1).Param(4).Param(64))
+
+BENCHMARK_CLASS(FrameQueue_Latency,
+	"FrameQueue.Latency",
+	Settings().Attempts(attempts).Operations(round_trips))
+
+BENCHMARK_CLASS(SpscQueue_Latency,
+	"SpscQueue.Latency",
+	Settings().Attempts(attempts).Operations(round_trips))
+
+BENCHMARK_MAIN()
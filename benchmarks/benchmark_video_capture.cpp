@@ -0,0 +1,351 @@
+/**
+ * benchmark: 	benchmark_video_capture
+ * description:	Per stage throughput of the capture, across the test data and output resolutions from 360p to 4K:
+ * 				demux only (packet index build, nothing is decoded), decode (yuv420p passthrough), conversion (every output
+ * 				format and scaler), end to end, decode pipeline hand off through frame_queue, open / release latency
+ * 				and scaling with concurrent captures.
+ * 				Every run reports frames/s (items/s) and the custom metrics ns_per_frame and bytes_per_frame. When the library
+ * 				is built with VCPP_STATS the per stage cost taken from get_stats() is reported too (*_ns_per_frame).
+ * 				Results to compare across library versions: benchmark_video_capture --output=json > results.json
+ * 				A subset is selected with --filter, e.g. --filter=Capture.Decode
+*/
+
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <video_capture/video_capture.hpp>
+#include <video_capture/raw_frame.hpp>
+#include <benchmark/cppbenchmark.h>
+
+const auto data_directory = std::string("../../../../tests/data/");
+const auto default_video = data_directory + "testsrc_30sec_30fps.mkv";
+const auto conversion_video = data_directory + "testsrc_10sec_30fps.mkv";
+
+const std::vector<std::string> videos = 
+{
+	"testsrc_10sec_4fps.mkv",
+	"testsrc_10sec_30fps.mkv",
+	"testsrc_30sec_30fps.mkv",
+	"testsrc_120sec_6fps.mkv",
+	"v.mp4"
+};
+
+// Synthetic resolutions: the output of the scaler, source frames are upscaled or downscaled to it.
+const std::vector<std::tuple<int, int>> resolutions = 
+{
+	{ 640, 360 },
+	{ 1280, 720 },
+	{ 1920, 1080 },
+	{ 2560, 1440 },
+	{ 3840, 2160 }
+};
+
+using clock_type = std::chrono::steady_clock;
+
+void add_frame_metrics(CppBenchmark::Context& context, int64_t frames, int64_t bytes_per_frame, clock_type::duration elapsed)
+{
+	const auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+	context.metrics().AddItems(frames);
+	context.metrics().AddBytes(frames * bytes_per_frame);
+	context.metrics().SetCustom("frames", frames);
+	context.metrics().SetCustom("bytes_per_frame", bytes_per_frame);
+	context.metrics().SetCustom("ns_per_frame", frames > 0 ? ns / frames : 0.0);
+	context.metrics().SetCustom("frames_per_second", ns > 0 ? frames * 1e9 / ns : 0.0);
+}
+
+void add_stage_metrics(CppBenchmark::Context& context, const vc::stats& s)
+{
+	if (!s.is_enabled || s.frames_decoded == 0)
+		return;
+
+	const auto per_frame = [&s](const vc::stage_stats& stage) { return static_cast<double>(stage.total.count()) / s.frames_decoded; };
+	context.metrics().SetCustom("read_ns_per_frame", per_frame(s.read));
+	context.metrics().SetCustom("decode_ns_per_frame", per_frame(s.decode));
+	context.metrics().SetCustom("transfer_ns_per_frame", per_frame(s.transfer));
+	context.metrics().SetCustom("convert_ns_per_frame", per_frame(s.convert));
+	context.metrics().SetCustom("convert_p99_ns", static_cast<int64_t>(s.convert.p99.count()));
+	context.metrics().SetCustom("bytes_read_per_frame", static_cast<int64_t>(s.bytes_read / s.frames_decoded));
+}
+
+/**
+ * Demux only: build_index() reads every packet of the video stream and decodes nothing.
+ * x: video
+*/
+class DemuxFixture : public CppBenchmark::Benchmark
+{
+public:
+    using Benchmark::Benchmark;
+
+protected:
+	vc::video_capture _vc;
+	std::string _video_path;
+	std::string _index_path;
+
+    void Initialize(CppBenchmark::Context& context) override
+	{
+		_video_path = data_directory + videos[context.x()];
+		_index_path = (std::filesystem::temp_directory_path() / "benchmark_video_capture.vcidx").string();
+		if(!_vc.open(_video_path))
+		{
+			std::cout << "Unable to open " << _video_path << std::endl;
+			context.Cancel();
+		}
+	}
+
+    void Cleanup(CppBenchmark::Context& context) override 
+	{ 
+		_vc.release();
+		std::filesystem::remove(_index_path);
+	}
+
+	void Run(CppBenchmark::Context& context) override
+	{	
+		const auto start = clock_type::now();
+		_vc.build_index(_index_path);
+		const auto elapsed = clock_type::now() - start;
+
+		const int64_t frames = _vc.get_frame_count().value_or(0);
+		const auto file_size = static_cast<int64_t>(std::filesystem::file_size(_video_path));
+		add_frame_metrics(context, frames, frames > 0 ? file_size / frames : 0, elapsed);
+	}
+};
+
+enum class read_mode { decode, conversion, end_to_end };
+
+/**
+ * Whole video read in a loop.
+ * decode: 		yuv420p passthrough, no conversion (x: video)
+ * conversion:	x: output pixel format, y: scaling algorithm, z: output resolution (shorter video: 120 combinations)
+ * end_to_end:	bgr24 at the source resolution (x: video)
+*/
+template<read_mode Mode>
+class ReadFixture : public CppBenchmark::Benchmark
+{
+public:
+    using Benchmark::Benchmark;
+
+protected:
+	vc::video_capture _vc;
+	vc::raw_frame _frame;
+
+    void Initialize(CppBenchmark::Context& context) override
+	{
+		auto video_path = conversion_video;
+		if constexpr (Mode == read_mode::decode)
+		{
+			video_path = data_directory + videos[context.x()];
+			_vc.set_output_pixel_format(vc::pixel_format::yuv420p);
+		}
+		else if constexpr (Mode == read_mode::conversion)
+		{
+			const auto [w, h] = resolutions[context.z()];
+			_vc.set_output_pixel_format(static_cast<vc::pixel_format>(context.x()));
+			_vc.set_scaling_algorithm(static_cast<vc::scaling_algorithm>(context.y()));
+			_vc.set_output_size(w, h);
+		}
+		else
+		{
+			video_path = data_directory + videos[context.x()];
+		}
+
+		if(!_vc.open(video_path))
+		{
+			std::cout << "Unable to open " << video_path << std::endl;
+			context.Cancel();
+			return;
+		}
+
+	    _frame.data.resize(_vc.get_frame_size_in_bytes().value());
+	}
+
+    void Cleanup(CppBenchmark::Context& context) override 
+	{ 
+		_vc.release();
+	}
+
+	void Run(CppBenchmark::Context& context) override
+	{	
+		int64_t frames = 0;
+		const auto start = clock_type::now();
+		while(_vc.read(&_frame))
+			++frames;
+		const auto elapsed = clock_type::now() - start;
+
+		add_frame_metrics(context, frames, static_cast<int64_t>(_frame.data.size()), elapsed);
+		add_stage_metrics(context, _vc.get_stats());
+	}
+};
+
+/**
+ * Decode pipeline: decoding and conversion on the capture thread, frames handed off through frame_queue.
+ * x: queue size
+*/
+class PipelineFixture : public CppBenchmark::Benchmark
+{
+public:
+    using Benchmark::Benchmark;
+
+protected:
+	vc::video_capture _vc;
+	vc::raw_frame _frame;
+
+    void Initialize(CppBenchmark::Context& context) override
+	{
+		if(!_vc.open(default_video))
+		{
+			std::cout << "Unable to open " << default_video << std::endl;
+			context.Cancel();
+			return;
+		}
+
+	    _frame.data.resize(_vc.get_frame_size_in_bytes().value());
+	}
+
+    void Cleanup(CppBenchmark::Context& context) override 
+	{ 
+		_vc.release();
+	}
+
+	void Run(CppBenchmark::Context& context) override
+	{	
+		int64_t frames = 0;
+		const auto start = clock_type::now();
+		_vc.start(static_cast<size_t>(context.x()));
+		while(_vc.read(&_frame))
+			++frames;
+		_vc.stop();
+		const auto elapsed = clock_type::now() - start;
+
+		add_frame_metrics(context, frames, static_cast<int64_t>(_frame.data.size()), elapsed);
+		add_stage_metrics(context, _vc.get_stats());
+	}
+};
+
+/**
+ * Open and release of the capture, one operation each. Includes the first frame: that is what a caller waits for.
+ * x: video
+*/
+class OpenReleaseFixture : public CppBenchmark::Benchmark
+{
+public:
+    using Benchmark::Benchmark;
+
+protected:
+	vc::video_capture _vc;
+	vc::raw_frame _frame;
+
+	void Run(CppBenchmark::Context& context) override
+	{	
+		const auto video_path = data_directory + videos[context.x()];
+		if(!_vc.open(video_path))
+		{
+			std::cout << "Unable to open " << video_path << std::endl;
+			context.Cancel();
+			return;
+		}
+
+		_vc.read(&_frame);
+		context.metrics().SetCustom("open_ns", static_cast<int64_t>(std::chrono::nanoseconds(_vc.get_open_time().value_or(clock_type::duration{})).count()));
+		context.metrics().SetCustom("first_frame_ns", static_cast<int64_t>(std::chrono::nanoseconds(_vc.get_first_frame_latency().value_or(clock_type::duration{})).count()));
+		_vc.release();
+	}
+};
+
+/**
+ * Concurrent captures, one thread each, on the same video: frames/s is the aggregate of all of them.
+ * x: number of captures
+*/
+class MultiCaptureFixture : public CppBenchmark::Benchmark
+{
+public:
+    using Benchmark::Benchmark;
+
+protected:
+	void Run(CppBenchmark::Context& context) override
+	{	
+		const auto captures = static_cast<size_t>(context.x());
+		std::vector<int64_t> frames(captures, 0);
+		std::vector<std::thread> threads;
+		int64_t bytes_per_frame = 0;
+
+		const auto start = clock_type::now();
+		for (size_t i = 0; i < captures; ++i)
+		{
+			threads.emplace_back([&frames, &bytes_per_frame, i]()
+			{
+				vc::video_capture vc;
+				if(!vc.open(default_video))
+					return;
+
+				vc::raw_frame frame;
+				frame.data.resize(vc.get_frame_size_in_bytes().value());
+				while(vc.read(&frame))
+					++frames[i];
+
+				if (i == 0)
+					bytes_per_frame = static_cast<int64_t>(frame.data.size());
+			});
+		}
+
+		for (auto& t : threads)
+			t.join();
+		const auto elapsed = clock_type::now() - start;
+
+		int64_t total = 0;
+		for (auto f : frames)
+			total += f;
+
+		add_frame_metrics(context, total, bytes_per_frame, elapsed);
+		context.metrics().SetCustom("captures", static_cast<int64_t>(captures));
+	}
+};
+
+using Read_Decode = ReadFixture<read_mode::decode>;
+using Read_Conversion = ReadFixture<read_mode::conversion>;
+using Read_EndToEnd = ReadFixture<read_mode::end_to_end>;
+
+const auto attempts = 5;
+const auto conversion_attempts = 3;
+const auto operations = 1;
+const auto open_operations = 20;
+
+const auto video_count = static_cast<int>(videos.size());
+const auto resolution_count = static_cast<int>(resolutions.size());
+
+BENCHMARK_CLASS(DemuxFixture,
+	"Capture.Demux",
+	Settings().Attempts(attempts).Operations(operations).ParamRange(0, video_count - 1))
+
+BENCHMARK_CLASS(Read_Decode,
+	"Capture.Decode",
+	Settings().Attempts(attempts).Operations(operations).ParamRange(0, video_count - 1))
+
+BENCHMARK_CLASS(Read_Conversion,
+	"Capture.Conversion",
+	Settings().Attempts(conversion_attempts).Operations(operations)
+		.TripleRange(
+			static_cast<int>(vc::pixel_format::bgr24), static_cast<int>(vc::pixel_format::nv12),
+			static_cast<int>(vc::scaling_algorithm::fast_bilinear), static_cast<int>(vc::scaling_algorithm::bicubic),
+			0, resolution_count - 1))
+
+BENCHMARK_CLASS(Read_EndToEnd,
+	"Capture.EndToEnd",
+	Settings().Attempts(attempts).Operations(operations).ParamRange(0, video_count - 1))
+
+BENCHMARK_CLASS(PipelineFixture,
+	"Capture.Pipeline",
+	Settings().Attempts(attempts).Operations(operations).Param(1).Param(4).Param(16))
+
+BENCHMARK_CLASS(OpenReleaseFixture,
+	"Capture.OpenRelease",
+	Settings().Attempts(attempts).Operations(open_operations).ParamRange(0, video_count - 1))
+
+BENCHMARK_CLASS(MultiCaptureFixture,
+	"Capture.MultiCapture",
+	Settings().Attempts(attempts).Operations(operations).Param(1).Param(2).Param(4).Param(8).Param(16))
+
+BENCHMARK_MAIN()
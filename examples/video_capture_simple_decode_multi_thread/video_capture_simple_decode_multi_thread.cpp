@@ -3,13 +3,13 @@
  * author:		Stefano Lusardi
  * date:		Jun 2021
  * description:	The simplest example to show video_capture API usage. 
- * 				Multi threaded: one thread decodes and enqueue frames, the other dequeues them in order.
- * 				This library provides a basic implementation of thread safe queue, 
- * 				but the it can be replaced with any other implementation on the application side.
+ * 				Multi threaded: video_capture internal pipeline demuxes, decodes and converts frames on background threads,
+ * 				the main thread dequeues them in order.
 */
 
 #include <iostream>
 #include <video_capture/video_capture.hpp>
+#include <video_capture/raw_frame.hpp>
 
 void log_callback(const std::string& str) { std::cout << "[::video_capture::] " << str << std::endl; }
 
@@ -29,18 +29,24 @@ int main(int argc, char** argv)
 	const auto size = vc.get_frame_size();
 	const auto [width, height] = size.value();
 
-	// Read video frame by frame
+	// Start the internal pipeline: demuxing, decoding and colour conversion run on background threads
+	vc.start();
+
+	// Read video frame by frame: each read pops the next ready frame
 	size_t num_decoded_frames = 0;
-	uint8_t* frame_data = {};
-	while(vc.read(&frame_data))
+	vc::raw_frame frame;
+	while(vc.read(&frame))
 	{
 		++num_decoded_frames;
-		// Use frame_data array
+		// Use frame.data array
 		// ...
 	}
 	
 	std::cout << "Decoded Frames: " << num_decoded_frames << std::endl;
 
+	// Stop the internal pipeline
+	vc.stop();
+
 	// Release and cleanup video_capture
 	vc.release();
 
@@ -15,6 +15,7 @@
 
 #include <video_capture/video_capture.hpp>
 #include <video_capture/raw_frame.hpp>
+#include <video_capture/frame_pool.hpp>
 
 #include <GLFW/glfw3.h>
 
@@ -78,12 +79,13 @@ int main(int argc, char **argv)
 	glOrtho(0, window_width, window_height, 0, -1, 1);
 	glMatrixMode(GL_MODELVIEW);
 
-	std::unique_ptr<vc::raw_frame> frame;
+	vc::frame_pool frame_pool(vc.get_frame_size_in_bytes().value(), 2);
+	vc::frame_pool::handle frame;
 	while (!glfwWindowShouldClose(window))
 	{
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		frame = std::make_unique<vc::raw_frame>();
+		frame = frame_pool.acquire();
 		if (!vc.read(frame.get()))
 		{
 			total_end_time = std::chrono::high_resolution_clock::now();
@@ -16,17 +16,19 @@
 #include <video_capture/video_capture.hpp>
 #include <video_capture/frame_queue.hpp>
 #include <video_capture/raw_frame.hpp>
+#include <video_capture/frame_pool.hpp>
 
 #include <GLFW/glfw3.h>
 
 using namespace std::chrono_literals;
 
-void decode_thread(vc::video_capture& vc, vc::frame_queue<std::unique_ptr<vc::raw_frame>>& frame_queue)
+void decode_thread(vc::video_capture& vc, vc::frame_pool& frame_pool, vc::frame_queue<vc::frame_pool::handle>& frame_queue)
 {
 	int frames_decoded = 0;
 	while(true)
 	{
-		auto frame = std::make_unique<vc::raw_frame>();
+		// Frames are recycled into the pool as soon as the render thread drops them.
+		auto frame = frame_pool.acquire();
 		if(!vc.read(frame.get()))
 		{
 			std::cout << "Video finished" << std::endl;
@@ -126,8 +128,10 @@ int main(int argc, char **argv)
 	const auto frame_size = vc.get_frame_size();
 	const auto [frame_width, frame_height] = frame_size.value();
 
-	vc::frame_queue<std::unique_ptr<vc::raw_frame>> frame_queue(3);
-	std::thread t(&decode_thread, std::ref(vc), std::ref(frame_queue));
+	// One frame owned by the decode thread, one owned by the render thread and the queued ones.
+	vc::frame_queue<vc::frame_pool::handle> frame_queue(3);
+	vc::frame_pool frame_pool(vc.get_frame_size_in_bytes().value(), frame_queue.get_max_size() + 2);
+	std::thread t(&decode_thread, std::ref(vc), std::ref(frame_pool), std::ref(frame_queue));
 
 	GLFWwindow *window = nullptr;
 	GLuint texture_handle;
@@ -136,7 +140,7 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 
 	int frames_shown = 0;
-	std::unique_ptr<vc::raw_frame> frame;
+	vc::frame_pool::handle frame;
 
 	std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<double>> start_time = std::chrono::steady_clock::now();
 	std::chrono::duration<double> elapsed_time(0.0);
@@ -0,0 +1,231 @@
+#!/usr/bin/env python3
+"""
+Benchmark baselines: store the JSON results of the benchmarks (--output=json) under a name
+and compare new runs against them.
+
+Every benchmark is run several times (one JSON file per run, or --exec/--repeat): a baseline keeps
+all the samples, the comparison uses median and MAD (median absolute deviation) so that a single
+noisy run neither hides nor fakes a regression.
+
+  benchmark_baseline.py save v1.2 run1.json run2.json run3.json
+  benchmark_baseline.py save v1.2 --exec "./benchmark_video_capture --output=json" --repeat 5
+  benchmark_baseline.py compare v1.2 new1.json new2.json new3.json --fail-on-regression
+  benchmark_baseline.py list
+
+A benchmark is a regression (or an improvement) when its median moves by more than both
+--threshold (relative) and --mad-factor times the combined noise of the two sample sets.
+Exit code is 1 with --fail-on-regression and at least one regression, 2 on usage errors.
+"""
+
+import argparse
+import datetime
+import json
+import os
+import shlex
+import statistics
+import subprocess
+import sys
+
+DEFAULT_STORE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "benchmarks", "baselines")
+
+# Metrics looked up in order: per frame cost when the benchmark reports it, time per operation otherwise.
+DEFAULT_METRICS = ["ns_per_frame", "avg_time"]
+
+# Scale factor that makes the MAD a consistent estimator of the standard deviation (normal distribution).
+MAD_SCALE = 1.4826
+
+
+def flatten_metrics(metrics):
+    """Numeric metrics of a phase, custom metrics (custom_int, custom_dbl, ...) moved to the top level."""
+    values = {}
+    for key, value in metrics.items():
+        if isinstance(value, dict):
+            values.update(flatten_metrics(value))
+        elif isinstance(value, (int, float)) and not isinstance(value, bool):
+            values[key] = float(value)
+    return values
+
+
+def find_phases(node, phases):
+    """Every object with a name and a metrics dictionary: one per benchmark and parameter set."""
+    if isinstance(node, dict):
+        if isinstance(node.get("name"), str) and isinstance(node.get("metrics"), dict):
+            phases[node["name"]] = flatten_metrics(node["metrics"])
+        for value in node.values():
+            find_phases(value, phases)
+    elif isinstance(node, list):
+        for value in node:
+            find_phases(value, phases)
+    return phases
+
+
+def select_metric(values, metrics):
+    for metric in metrics:
+        if metric in values:
+            return metric, values[metric]
+    return None, None
+
+
+def load_runs(paths, command, repeat):
+    """List of runs, each one a dictionary benchmark name -> metrics."""
+    runs = []
+    for path in paths:
+        with open(path) as f:
+            runs.append(find_phases(json.load(f), {}))
+
+    for i in range(repeat if command else 0):
+        print("Run {}/{}: {}".format(i + 1, repeat, command), file=sys.stderr)
+        output = subprocess.run(shlex.split(command), check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+        runs.append(find_phases(json.loads(output[output.index("{"):]), {}))
+
+    return [run for run in runs if run]
+
+
+def collect_samples(runs, metrics):
+    """Benchmark name -> (metric, samples), one sample per run."""
+    samples = {}
+    for run in runs:
+        for name, values in run.items():
+            metric, value = select_metric(values, metrics)
+            if metric is not None:
+                samples.setdefault(name, (metric, []))[1].append(value)
+    return samples
+
+
+def median_mad(values):
+    median = statistics.median(values)
+    return median, statistics.median([abs(v - median) for v in values])
+
+
+def baseline_path(store, name):
+    return os.path.join(store, name + ".json")
+
+
+def save(args):
+    runs = load_runs(args.results, args.exec, args.repeat)
+    if not runs:
+        print("No benchmark results to save", file=sys.stderr)
+        return 2
+
+    os.makedirs(args.store, exist_ok=True)
+    baseline = {
+        "name": args.name,
+        "created": datetime.datetime.now().isoformat(timespec="seconds"),
+        "runs": runs,
+    }
+    with open(baseline_path(args.store, args.name), "w") as f:
+        json.dump(baseline, f, indent=2, sort_keys=True)
+
+    print("Baseline {} saved: {} runs, {} benchmarks".format(args.name, len(runs), len(collect_samples(runs, args.metric))))
+    return 0
+
+
+def compare(args):
+    path = baseline_path(args.store, args.name)
+    if not os.path.exists(path):
+        print("Baseline {} not found in {}".format(args.name, args.store), file=sys.stderr)
+        return 2
+
+    with open(path) as f:
+        base = collect_samples(json.load(f)["runs"], args.metric)
+
+    runs = load_runs(args.results, args.exec, args.repeat)
+    if not runs:
+        print("No benchmark results to compare", file=sys.stderr)
+        return 2
+    new = collect_samples(runs, args.metric)
+
+    rows = []
+    regressions = 0
+    for name in sorted(set(base) | set(new)):
+        if name not in new:
+            rows.append((name, "", "", "", "", "missing"))
+            continue
+        if name not in base:
+            rows.append((name, new[name][0], "", "{:.4g}".format(median_mad(new[name][1])[0]), "", "new"))
+            continue
+
+        metric, base_values = base[name]
+        new_metric, new_values = new[name]
+        if metric != new_metric:
+            rows.append((name, metric, "", "", "", "metric changed"))
+            continue
+
+        base_median, base_mad = median_mad(base_values)
+        new_median, new_mad = median_mad(new_values)
+        delta = new_median - base_median
+        relative = delta / base_median if base_median else 0.0
+
+        # Lower is better for every time based metric, higher for rates (per second).
+        higher_is_better = metric.endswith("per_second")
+        noise = args.mad_factor * MAD_SCALE * (base_mad ** 2 + new_mad ** 2) ** 0.5
+        status = "unchanged"
+        if abs(delta) > noise and abs(relative) > args.threshold:
+            is_worse = (delta < 0) if higher_is_better else (delta > 0)
+            status = "REGRESSION" if is_worse else "improvement"
+            regressions += is_worse
+
+        rows.append((name, metric, "{:.4g}".format(base_median), "{:.4g}".format(new_median), "{:+.1%}".format(relative), status))
+
+    header = ("benchmark", "metric", "baseline", "new", "delta", "status")
+    widths = [max(len(str(row[i])) for row in rows + [header]) for i in range(len(header))]
+    for row in [header] + rows:
+        if args.only_changes and row is not header and row[5] == "unchanged":
+            continue
+        print("  ".join(str(value).ljust(width) for value, width in zip(row, widths)).rstrip())
+
+    print("\n{} benchmarks, {} regressions, {} improvements (baseline {}: {} runs, new: {} runs)".format(
+        len(rows), regressions, sum(row[5] == "improvement" for row in rows), args.name, max(len(v[1]) for v in base.values()) if base else 0, len(runs)))
+
+    return 1 if args.fail_on_regression and regressions > 0 else 0
+
+
+def list_baselines(args):
+    if not os.path.isdir(args.store):
+        return 0
+
+    for file in sorted(os.listdir(args.store)):
+        if file.endswith(".json"):
+            with open(os.path.join(args.store, file)) as f:
+                baseline = json.load(f)
+            print("{}  {}  {} runs".format(baseline["name"], baseline["created"], len(baseline["runs"])))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--store", default=DEFAULT_STORE, help="Baselines directory (default: benchmarks/baselines)")
+    parser.add_argument("--metric", action="append", help="Metric to compare, repeat for fallbacks (default: {})".format(", ".join(DEFAULT_METRICS)))
+    commands = parser.add_subparsers(dest="command")
+
+    for command in ["save", "compare"]:
+        p = commands.add_parser(command)
+        p.add_argument("name", help="Baseline name, e.g. a version or a commit")
+        p.add_argument("results", nargs="*", help="JSON results, one file per run")
+        p.add_argument("--exec", help="Benchmark command line printing JSON results, run --repeat times")
+        p.add_argument("--repeat", type=int, default=5, help="Runs of --exec (default: 5)")
+
+        if command == "compare":
+            p.add_argument("--threshold", type=float, default=0.05, help="Minimum relative change (default: 0.05)")
+            p.add_argument("--mad-factor", type=float, default=3.0, help="Minimum change in units of noise (default: 3)")
+            p.add_argument("--fail-on-regression", action="store_true", help="Exit code 1 if any benchmark regressed")
+            p.add_argument("--only-changes", action="store_true", help="Hide unchanged benchmarks")
+
+    commands.add_parser("list")
+
+    args = parser.parse_args()
+    args.metric = args.metric or DEFAULT_METRICS
+
+    if args.command == "save":
+        return save(args)
+    if args.command == "compare":
+        return compare(args)
+    if args.command == "list":
+        return list_baselines(args)
+
+    parser.print_help()
+    return 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
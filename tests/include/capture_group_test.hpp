@@ -0,0 +1,41 @@
+#pragma once 
+
+#include <gtest/gtest.h>
+#include <video_capture/capture_group.hpp>
+#include <video_capture/raw_frame.hpp>
+
+
+namespace vc::test
+{
+
+class capture_group_test : public ::testing::Test
+{
+protected:
+    explicit capture_group_test()
+    : test_data_directory{"../data/"}
+    { }
+
+    virtual ~capture_group_test() { }
+
+    virtual void SetUp() override { }
+    virtual void TearDown() override { }
+
+    // Frames of a source read one at a time with a standalone video_capture, as reference.
+    std::vector<double> read_timestamps(const std::string& video_path) const
+    {
+        vc::video_capture vc;
+        std::vector<double> timestamps;
+        if (!vc.open(video_path))
+            return timestamps;
+
+        vc::raw_frame frame;
+        frame.data.resize(vc.get_frame_size_in_bytes().value());
+        while (vc.read(&frame))
+            timestamps.push_back(frame.pts);
+        return timestamps;
+    }
+
+    const std::string test_data_directory;
+};
+
+}
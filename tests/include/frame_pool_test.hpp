@@ -0,0 +1,29 @@
+#pragma once 
+
+#include <gtest/gtest.h>
+#include <video_capture/video_capture.hpp>
+
+#include <atomic>
+
+namespace vc::test
+{
+size_t get_allocation_count();
+
+class frame_pool_test : public ::testing::Test
+{
+protected:
+    explicit frame_pool_test()
+    : vc{ std::make_unique<vc::video_capture>() }
+    , test_data_directory{"../data/"}
+    { }
+
+    virtual ~frame_pool_test() { vc->release(); }
+
+    virtual void SetUp() override { }
+    virtual void TearDown() override { }
+
+    std::unique_ptr<vc::video_capture> vc;
+    const std::string test_data_directory;
+};
+
+}
@@ -0,0 +1,17 @@
+#pragma once 
+
+#include <gtest/gtest.h>
+
+namespace vc::test
+{
+
+class frame_queue_test : public ::testing::Test
+{
+protected:
+    explicit frame_queue_test() { }
+    virtual ~frame_queue_test() { }
+    virtual void SetUp() override { }
+    virtual void TearDown() override { }
+};
+
+}
@@ -0,0 +1,17 @@
+#pragma once 
+
+#include <gtest/gtest.h>
+
+namespace vc::test
+{
+
+class spsc_queue_test : public ::testing::Test
+{
+protected:
+    explicit spsc_queue_test() { }
+    virtual ~spsc_queue_test() { }
+    virtual void SetUp() override { }
+    virtual void TearDown() override { }
+};
+
+}
@@ -23,7 +23,6 @@ protected:
     std::unique_ptr<vc::video_capture> vc;
     const std::string test_data_directory;
 
-private:
     template<typename... Args>
     void log(Args&&... args) const
     {
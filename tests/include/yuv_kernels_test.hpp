@@ -0,0 +1,17 @@
+#pragma once 
+
+#include <gtest/gtest.h>
+
+namespace vc::test
+{
+
+class yuv_kernels_test : public ::testing::Test
+{
+protected:
+    explicit yuv_kernels_test() { }
+    virtual ~yuv_kernels_test() { }
+    virtual void SetUp() override { }
+    virtual void TearDown() override { }
+};
+
+}
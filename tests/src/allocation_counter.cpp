@@ -0,0 +1,49 @@
+#include <frame_pool_test.hpp>
+
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions: linked into frame_pool_tests only, so that the other test suites
+// (and gtest itself) run with the regular allocator. Kept in its own translation unit, away from the delete expressions.
+namespace
+{
+    std::atomic<size_t> allocation_count{ 0 };
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        ++allocation_count;
+        size = size ? size : 1;
+    #if defined(_WIN32)
+        void* p = _aligned_malloc(size, alignment);
+    #else
+        void* p = nullptr;
+        if (posix_memalign(&p, std::max(alignment, sizeof(void*)), size) != 0)
+            p = nullptr;
+    #endif
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+
+    void deallocate(void* p) noexcept
+    {
+    #if defined(_WIN32)
+        _aligned_free(p);
+    #else
+        std::free(p);
+    #endif
+    }
+}
+
+// Count every C++ heap allocation performed by the test executable (and by the library linked to it).
+void* operator new(std::size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocate(size, static_cast<std::size_t>(alignment)); }
+void operator delete(void* p) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { deallocate(p); }
+
+namespace vc::test
+{
+size_t get_allocation_count() { return allocation_count.load(); }
+}
@@ -0,0 +1,174 @@
+#include <capture_group_test.hpp>
+
+#include <map>
+#include <thread>
+
+namespace vc::test
+{
+TEST_F(capture_group_test, read_all_sources)
+{ 
+    const std::vector<std::string> paths = {
+        test_data_directory + "testsrc_10sec_4fps.mkv",
+        test_data_directory + "testsrc_10sec_6fps.mkv",
+        test_data_directory + "testsrc_10sec_10fps.mkv",
+        test_data_directory + "testsrc_10sec_4fps.mkv" };
+
+    vc::capture_group group(2);
+    ASSERT_FALSE(group.start());
+    for (size_t i = 0; i < paths.size(); ++i)
+        ASSERT_EQ(group.add_source(paths[i]), static_cast<int>(i));
+    ASSERT_EQ(group.get_source_count(), paths.size());
+    ASSERT_EQ(group.get_thread_count(), 2);
+
+    ASSERT_TRUE(group.start());
+    ASSERT_TRUE(group.is_running());
+    ASSERT_EQ(group.add_source(paths[0]), -1);
+
+    // Frames of different sources are interleaved, but every source delivers all its frames in order.
+    std::map<int, std::vector<double>> timestamps;
+    vc::raw_frame frame;
+    int source_id = -1;
+    while (group.read(&frame, &source_id))
+    {
+        ASSERT_EQ(static_cast<int>(frame.data.size()), group.get_frame_size_in_bytes(source_id).value());
+        timestamps[source_id].push_back(frame.pts);
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i)
+        ASSERT_EQ(timestamps[static_cast<int>(i)], read_timestamps(paths[i]));
+
+    group.stop();
+    ASSERT_FALSE(group.is_running());
+}
+
+TEST_F(capture_group_test, sources_take_turns)
+{ 
+    // More sources than workers: decode tasks run a packet at a time, so a single worker serves all of them together
+    // instead of one source after the other.
+    vc::capture_group group(1, 1, 2);
+    for (int i = 0; i < 6; ++i)
+        ASSERT_EQ(group.add_source(test_data_directory + "testsrc_10sec_10fps.mkv"), i);
+    ASSERT_TRUE(group.start());
+
+    std::map<int, size_t> counts;
+    vc::raw_frame frame;
+    int source_id = -1;
+    for (int i = 0; i < 6 * 10; ++i)
+    {
+        ASSERT_TRUE(group.read(&frame, &source_id));
+        ++counts[source_id];
+    }
+
+    ASSERT_EQ(counts.size(), 6);
+    group.stop();
+}
+
+TEST_F(capture_group_test, multiple_output_queues)
+{ 
+    vc::capture_group group(3, 2, 2);
+    ASSERT_EQ(group.add_source(test_data_directory + "testsrc_10sec_4fps.mkv", 0), 0);
+    ASSERT_EQ(group.add_source(test_data_directory + "testsrc_10sec_6fps.mkv", 1), 1);
+    ASSERT_EQ(group.add_source(test_data_directory + "testsrc_10sec_10fps.mkv", 1), 2);
+    ASSERT_EQ(group.add_source(test_data_directory + "testsrc_10sec_10fps.mkv", 2), -1);
+
+    // Configuration is applied to the source before it gets opened.
+    ASSERT_EQ(group.add_source(test_data_directory + "testsrc_10sec_4fps.mkv", 0, vc::decode_support::none,
+        [](vc::video_capture& vc) { vc.set_output_pixel_format(vc::pixel_format::gray8); }), 3);
+
+    ASSERT_TRUE(group.start());
+
+    std::map<int, size_t> counts_0;
+    std::thread consumer([&group, &counts_0]()
+    {
+        vc::raw_frame frame;
+        int source_id = -1;
+        while (group.read(&frame, &source_id, 0))
+            ++counts_0[source_id];
+    });
+
+    std::map<int, size_t> counts_1;
+    vc::raw_frame frame;
+    int source_id = -1;
+    while (group.read(&frame, &source_id, 1))
+        ++counts_1[source_id];
+
+    consumer.join();
+
+    ASSERT_EQ(counts_0.size(), 2);
+    ASSERT_EQ(counts_1.size(), 2);
+    ASSERT_EQ(counts_0[0], read_timestamps(test_data_directory + "testsrc_10sec_4fps.mkv").size());
+    ASSERT_EQ(counts_0[3], counts_0[0]);
+    ASSERT_EQ(counts_1[2], read_timestamps(test_data_directory + "testsrc_10sec_10fps.mkv").size());
+
+    const auto [w, h] = group.get_frame_size(3).value();
+    ASSERT_EQ(group.get_frame_size_in_bytes(3).value(), w * h);
+}
+
+TEST_F(capture_group_test, invalid_source)
+{ 
+    vc::capture_group group(2);
+    ASSERT_EQ(group.add_source("invalid_path"), 0);
+    ASSERT_EQ(group.add_source(test_data_directory + "testsrc_10sec_4fps.mkv"), 1);
+    ASSERT_TRUE(group.start());
+
+    size_t count = 0;
+    vc::raw_frame frame;
+    int source_id = -1;
+    while (group.read(&frame, &source_id))
+    {
+        ASSERT_EQ(source_id, 1);
+        ++count;
+    }
+
+    ASSERT_EQ(count, read_timestamps(test_data_directory + "testsrc_10sec_4fps.mkv").size());
+    ASSERT_EQ(group.get_frame_size(0), std::nullopt);
+}
+
+TEST_F(capture_group_test, stop_while_running)
+{ 
+    vc::capture_group group(2, 1, 1);
+    for (int i = 0; i < 8; ++i)
+        ASSERT_EQ(group.add_source(test_data_directory + "testsrc_30sec_30fps.mkv"), i);
+    ASSERT_TRUE(group.start());
+
+    // Consumer stops reading early: parked sources must not keep the workers busy or block stop().
+    vc::raw_frame frame;
+    int source_id = -1;
+    ASSERT_TRUE(group.read(&frame, &source_id));
+    group.stop();
+    ASSERT_FALSE(group.is_running());
+    ASSERT_FALSE(group.read(&frame, &source_id));
+}
+
+TEST_F(capture_group_test, stop_while_decoding)
+{ 
+    // Sources do not park after one frame: workers are still decoding and resubmitting when stop() joins them.
+    vc::capture_group group(4, 1, 8);
+    for (int i = 0; i < 8; ++i)
+        ASSERT_EQ(group.add_source(test_data_directory + "testsrc_30sec_30fps.mkv"), i);
+    ASSERT_TRUE(group.start());
+
+    // Consumer keeps reading (and resuming parked sources) while the group is stopped from another thread.
+    std::thread consumer([&group]() {
+        vc::raw_frame frame;
+        int source_id = -1;
+        while (group.read(&frame, &source_id))
+            ;
+    });
+
+    vc::raw_frame frame;
+    int source_id = -1;
+    for (int i = 0; i < 16; ++i)
+        ASSERT_TRUE(group.read(&frame, &source_id));
+
+    group.stop();
+    consumer.join();
+    ASSERT_FALSE(group.is_running());
+
+    // Group can be started again after a stop.
+    ASSERT_TRUE(group.start());
+    ASSERT_TRUE(group.read(&frame, &source_id));
+    group.stop();
+}
+
+}
@@ -0,0 +1,90 @@
+#include <frame_pool_test.hpp>
+#include <video_capture/frame_pool.hpp>
+
+namespace vc::test
+{
+TEST_F(frame_pool_test, acquire_presized_aligned)
+{
+    vc::frame_pool pool(1920 * 1080 * 3, 4);
+    ASSERT_EQ(pool.available(), 4);
+
+    auto frame = pool.acquire();
+    ASSERT_EQ(frame->data.size(), 1920 * 1080 * 3);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(frame->data.data()) % 64, 0);
+    ASSERT_EQ(pool.available(), 3);
+
+    frame.reset();
+    ASSERT_EQ(pool.available(), 4);
+}
+
+TEST_F(frame_pool_test, frame_outlives_pool)
+{
+    vc::frame_pool::handle frame;
+    {
+        vc::frame_pool pool(64, 1);
+        frame = pool.acquire();
+    }
+    ASSERT_EQ(frame->data.size(), 64);
+    frame.reset();
+}
+
+TEST_F(frame_pool_test, no_allocations_after_warm_up)
+{
+    vc::frame_pool pool(1920 * 1080 * 3, 3);
+
+    const auto allocations = get_allocation_count();
+    for (int i = 0; i < 100; ++i)
+    {
+        auto frame_0 = pool.acquire();
+        auto frame_1 = pool.acquire();
+        frame_0.reset();
+        auto frame_2 = std::move(frame_1);
+    }
+    ASSERT_EQ(get_allocation_count() - allocations, 0);
+}
+
+TEST_F(frame_pool_test, decode_no_allocations_per_frame)
+{
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_30fps.mkv"));
+    vc::frame_pool pool(vc->get_frame_size_in_bytes().value(), 3);
+
+    const int warm_up_frames = 10;
+    for (int i = 0; i < warm_up_frames; ++i)
+    {
+        auto frame = pool.acquire();
+        ASSERT_TRUE(vc->read(frame.get()));
+    }
+
+    const int measured_frames = 100;
+    const auto allocations = get_allocation_count();
+    for (int i = 0; i < measured_frames; ++i)
+    {
+        auto frame = pool.acquire();
+        ASSERT_TRUE(vc->read(frame.get()));
+    }
+
+    const auto allocations_per_frame = static_cast<double>(get_allocation_count() - allocations) / measured_frames;
+    ASSERT_EQ(allocations_per_frame, 0.0);
+}
+
+TEST_F(frame_pool_test, float_read_no_allocations_per_frame)
+{
+    // Resize and letterbox: taps and row buffers are computed on the first frame only.
+    vc->set_output_size(320, 320);
+    vc->set_letterbox(true);
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_30fps.mkv"));
+    std::vector<float> tensor(3 * 320 * 320);
+
+    const int warm_up_frames = 10;
+    for (int i = 0; i < warm_up_frames; ++i)
+        ASSERT_TRUE(vc->read(tensor.data()));
+
+    const int measured_frames = 100;
+    const auto allocations = get_allocation_count();
+    for (int i = 0; i < measured_frames; ++i)
+        ASSERT_TRUE(vc->read(tensor.data()));
+
+    ASSERT_EQ(get_allocation_count() - allocations, 0);
+}
+
+}
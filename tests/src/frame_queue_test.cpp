@@ -0,0 +1,145 @@
+#include <frame_queue_test.hpp>
+#include <video_capture/frame_queue.hpp>
+
+#include <memory>
+#include <thread>
+
+namespace vc::test
+{
+
+TEST_F(frame_queue_test, block_by_default)
+{
+    vc::frame_queue<std::unique_ptr<int>> queue(1);
+    ASSERT_EQ(queue.get_overflow_policy(), vc::overflow_policy::block);
+    ASSERT_TRUE(queue.put(std::make_unique<int>(0)));
+
+    // Producer waits for room instead of dropping anything.
+    std::thread producer([&queue]() { queue.put(std::make_unique<int>(1)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(queue.size(), 1);
+
+    std::unique_ptr<int> value;
+    queue.get(&value);
+    ASSERT_EQ(*value, 0);
+    producer.join();
+    queue.get(&value);
+    ASSERT_EQ(*value, 1);
+    ASSERT_EQ(queue.get_dropped_count(), 0);
+}
+
+TEST_F(frame_queue_test, drop_newest)
+{
+    vc::frame_queue<int> queue(2, vc::overflow_policy::drop_newest);
+    ASSERT_TRUE(queue.put(0));
+    ASSERT_TRUE(queue.put(1));
+    ASSERT_FALSE(queue.put(2));
+    ASSERT_FALSE(queue.put(3));
+    ASSERT_EQ(queue.get_dropped_count(), 2);
+
+    int value = -1;
+    queue.get(&value);
+    ASSERT_EQ(value, 0);
+    queue.get(&value);
+    ASSERT_EQ(value, 1);
+    ASSERT_TRUE(queue.is_empty());
+}
+
+TEST_F(frame_queue_test, drop_oldest)
+{
+    vc::frame_queue<int> queue(2, vc::overflow_policy::drop_oldest);
+    for (int i = 0; i < 5; ++i)
+        ASSERT_TRUE(queue.put(i));
+    ASSERT_EQ(queue.size(), 2);
+    ASSERT_EQ(queue.get_dropped_count(), 3);
+
+    int value = -1;
+    queue.get(&value);
+    ASSERT_EQ(value, 3);
+    queue.get(&value);
+    ASSERT_EQ(value, 4);
+}
+
+TEST_F(frame_queue_test, keep_latest)
+{
+    // Mailbox: a single slot, whatever the requested size.
+    vc::frame_queue<int> queue(8, vc::overflow_policy::keep_latest);
+    ASSERT_EQ(queue.get_max_size(), 1);
+    for (int i = 0; i < 5; ++i)
+        ASSERT_TRUE(queue.put(i));
+    ASSERT_EQ(queue.get_dropped_count(), 4);
+
+    int value = -1;
+    queue.get(&value);
+    ASSERT_EQ(value, 4);
+    ASSERT_TRUE(queue.is_empty());
+
+    queue.set_max_size(8);
+    ASSERT_EQ(queue.get_max_size(), 1);
+}
+
+TEST_F(frame_queue_test, not_default_constructible)
+{
+    // Items without default constructor (e.g. pooled frame handles) can be dropped too.
+    struct item
+    {
+        explicit item(int v) : value{ v } {}
+        int value;
+    };
+
+    vc::frame_queue<item> queue(2, vc::overflow_policy::drop_oldest);
+    for (int i = 0; i < 3; ++i)
+        ASSERT_TRUE(queue.put(item(i)));
+    ASSERT_EQ(queue.get_dropped_count(), 1);
+    ASSERT_EQ(queue.get().value, 1);
+}
+
+TEST_F(frame_queue_test, blocking_override)
+{
+    // End of stream markers must get through whatever the policy.
+    vc::frame_queue<int> queue(1, vc::overflow_policy::drop_newest);
+    ASSERT_TRUE(queue.put(0));
+
+    std::thread producer([&queue]() { queue.put(-1, vc::overflow_policy::block); });
+
+    int value = 0;
+    queue.get(&value);
+    ASSERT_EQ(value, 0);
+    queue.get(&value);
+    ASSERT_EQ(value, -1);
+    producer.join();
+    ASSERT_EQ(queue.get_dropped_count(), 0);
+}
+
+TEST_F(frame_queue_test, slow_consumer_sees_latest)
+{
+    const int items = 10'000;
+    vc::frame_queue<int> queue(1, vc::overflow_policy::keep_latest);
+
+    std::thread producer([&queue]()
+    {
+        for (int i = 0; i < items; ++i)
+            queue.put(i);
+        queue.put(-1, vc::overflow_policy::block);
+    });
+
+    // Producer never waits: values only move forward and every missing one was counted as dropped.
+    int value = 0;
+    int last = -1;
+    size_t received = 0;
+    while (true)
+    {
+        queue.get(&value);
+        if (value < 0)
+            break;
+        ASSERT_GT(value, last);
+        last = value;
+        ++received;
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
+
+    producer.join();
+    ASSERT_EQ(last, items - 1);
+    ASSERT_EQ(received + queue.get_dropped_count(), static_cast<size_t>(items));
+}
+
+}
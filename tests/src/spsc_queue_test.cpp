@@ -0,0 +1,57 @@
+#include <spsc_queue_test.hpp>
+#include <video_capture/spsc_queue.hpp>
+
+#include <memory>
+#include <thread>
+
+namespace vc::test
+{
+
+TEST_F(spsc_queue_test, try_get_empty)
+{
+    vc::spsc_queue<std::unique_ptr<int>> queue(3);
+    std::unique_ptr<int> value;
+    ASSERT_TRUE(queue.is_empty());
+    ASSERT_FALSE(queue.try_get(&value));
+
+    queue.put(std::make_unique<int>(42));
+    ASSERT_EQ(queue.size(), 1);
+    ASSERT_TRUE(queue.try_get(&value));
+    ASSERT_EQ(*value, 42);
+    ASSERT_TRUE(queue.is_empty());
+}
+
+TEST_F(spsc_queue_test, bounded_size)
+{
+    vc::spsc_queue<int> queue(3);
+    ASSERT_EQ(queue.get_max_size(), 3);
+    ASSERT_TRUE(queue.try_put(0));
+    ASSERT_TRUE(queue.try_put(1));
+    ASSERT_TRUE(queue.try_put(2));
+    ASSERT_FALSE(queue.try_put(3));
+    ASSERT_EQ(queue.size(), 3);
+}
+
+TEST_F(spsc_queue_test, producer_consumer_order)
+{
+    const int items = 100'000;
+    vc::spsc_queue<int> queue(4);
+
+    std::thread producer([&queue]()
+    {
+        for (int i = 0; i < items; ++i)
+            queue.put(i);
+    });
+
+    int value = -1;
+    for (int i = 0; i < items; ++i)
+    {
+        queue.get(&value);
+        ASSERT_EQ(value, i);
+    }
+
+    producer.join();
+    ASSERT_TRUE(queue.is_empty());
+}
+
+}
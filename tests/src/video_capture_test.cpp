@@ -1,4 +1,13 @@
 #include <video_capture_test.hpp>
+#include <video_capture/decoded_frame.hpp>
+#include <video_capture/raw_frame.hpp>
+
+#include <mutex>
+#include <thread>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
 
 namespace vc::test
 {
@@ -33,6 +42,918 @@ TEST_F(video_capture_test, info_callback)
     ASSERT_EQ(info_msg, "Video Capture is initialized");
 }
 
+TEST_F(video_capture_test, log_async)
+{ 
+    std::mutex mutex;
+    std::vector<std::string> messages;
+    std::vector<std::thread::id> threads;
+    vc->set_log_callback([&](const std::string& s){ 
+        std::lock_guard lock(mutex);
+        messages.push_back(s);
+        threads.push_back(std::this_thread::get_id());
+    }, vc::log_level::error);
+
+    vc->set_log_mode(vc::log_mode::async);
+    for (int i = 0; i < 20; ++i)
+        vc->get_frame_count();
+
+    // Back to sync mode: pending messages are delivered before returning.
+    vc->set_log_mode(vc::log_mode::sync);
+    vc->set_log_callback([](const std::string&){ }, vc::log_level::error);
+
+    // Identical messages are rate limited (a few per second).
+    ASSERT_FALSE(messages.empty());
+    ASSERT_LT(messages.size(), 20);
+    for (const auto& id : threads)
+        ASSERT_NE(id, std::this_thread::get_id());
+}
+
+TEST_F(video_capture_test, log_suppressed_count)
+{ 
+    // Leftovers of previous tests are reported before the callback is set.
+    vc->release();
+
+    std::vector<std::string> messages;
+    vc->set_log_callback([&](const std::string& s){ messages.push_back(s); }, vc::log_level::error);
+    for (int i = 0; i < 20; ++i)
+        vc->get_frame_count();
+
+    // Same error never comes back: its suppressed count is reported by release().
+    vc->release();
+    vc->set_log_callback([](const std::string&){ }, vc::log_level::error);
+
+    const std::string suffix = "identical messages suppressed)";
+    ASSERT_LT(messages.size(), 20);
+    ASSERT_NE(messages.back().find(suffix), std::string::npos);
+
+    // Every call is either delivered or counted, also when the loop crosses a second boundary.
+    int total = 0;
+    for (const auto& s : messages)
+    {
+        const auto pos = s.find(suffix);
+        if (pos == std::string::npos)
+        {
+            ++total;
+            continue;
+        }
+
+        const auto start = s.rfind('(', pos) + 1;
+        total += std::stoi(s.substr(start, pos - start));
+    }
+    ASSERT_EQ(total, 20);
+}
+
+TEST_F(video_capture_test, output_pixel_format)
+{ 
+    vc->set_output_pixel_format(vc::pixel_format::yuv420p);
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    ASSERT_EQ(vc->get_output_pixel_format(), vc::pixel_format::yuv420p);
+
+    const auto [w, h] = vc->get_frame_size().value();
+    ASSERT_EQ(vc->get_frame_size_in_bytes().value(), w * h * 3 / 2);
+
+    uint8_t* data = nullptr;
+    ASSERT_TRUE(vc->read(&data));
+    ASSERT_NE(data, nullptr);
+}
+
+TEST_F(video_capture_test, output_size)
+{ 
+    ASSERT_EQ(vc->get_scaling_algorithm(), vc::scaling_algorithm::bicubic);
+
+    for (auto algorithm : { vc::scaling_algorithm::fast_bilinear, vc::scaling_algorithm::bilinear, vc::scaling_algorithm::area, vc::scaling_algorithm::bicubic })
+    {
+        vc->set_output_size(160, 90);
+        vc->set_scaling_algorithm(algorithm);
+        ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+        ASSERT_EQ(vc->get_scaling_algorithm(), algorithm);
+        ASSERT_EQ(vc->get_frame_size(), std::make_tuple(160, 90));
+        ASSERT_EQ(vc->get_frame_size_in_bytes().value(), 160 * 90 * 3);
+
+        vc::raw_frame frame;
+        frame.data.resize(vc->get_frame_size_in_bytes().value());
+        ASSERT_TRUE(vc->read(&frame));
+    }
+
+    // Resizing applies to formats that would otherwise be passed through untouched.
+    vc->set_output_pixel_format(vc::pixel_format::yuv420p);
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    ASSERT_EQ(vc->get_frame_size_in_bytes().value(), 160 * 90 * 3 / 2);
+    uint8_t* data = nullptr;
+    ASSERT_TRUE(vc->read(&data));
+
+    // Non positive sizes restore the source resolution.
+    vc->set_output_size(0, 0);
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    const auto [w, h] = vc->get_frame_size().value();
+    ASSERT_NE(std::make_tuple(w, h), std::make_tuple(160, 90));
+}
+
+TEST_F(video_capture_test, output_size_keeps_range)
+{ 
+    // Reference luma range: unresized yuv420p output is the decoded Y plane as is.
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    vc->set_output_pixel_format(vc::pixel_format::yuv420p);
+    ASSERT_TRUE(vc->open(video_path));
+    const auto [w, h] = vc->get_frame_size().value();
+    uint8_t* data = nullptr;
+    ASSERT_TRUE(vc->read(&data));
+    const auto [src_min, src_max] = std::minmax_element(data, data + w * h);
+    const int y_min = *src_min;
+    const int y_max = *src_max;
+
+    // YUV and gray outputs keep the source range, whether resized by a single context or by slices (same height).
+    // Bilinear filtering does not overshoot: a stretch to full range would move the extremes by far more than rounding.
+    vc->set_scaling_algorithm(vc::scaling_algorithm::bilinear);
+    for (auto format : { vc::pixel_format::yuv420p, vc::pixel_format::nv12, vc::pixel_format::gray8 })
+    {
+        for (auto [threads, out_w, out_h] : { std::make_tuple(1, w / 2, h / 2), std::make_tuple(4, w / 2, h) })
+        {
+            vc->set_output_pixel_format(format);
+            vc->set_conversion_threads(threads);
+            vc->set_output_size(out_w, out_h);
+            ASSERT_TRUE(vc->open(video_path));
+            ASSERT_TRUE(vc->read(&data));
+
+            const auto [dst_min, dst_max] = std::minmax_element(data, data + out_w * out_h);
+            ASSERT_GE(*dst_min, y_min - 2);
+            ASSERT_LE(*dst_max, y_max + 2);
+        }
+    }
+}
+
+TEST_F(video_capture_test, crop)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    vc->set_output_pixel_format(vc::pixel_format::yuv420p);
+    ASSERT_TRUE(vc->open(video_path));
+    const auto [w, h] = vc->get_frame_size().value();
+    uint8_t* full = nullptr;
+    ASSERT_TRUE(vc->read(&full));
+    const std::vector<uint8_t> full_frame(full, full + vc->get_frame_size_in_bytes().value());
+
+    // Origin is aligned down to the chroma grid.
+    vc::video_capture crop_vc;
+    crop_vc.set_output_pixel_format(vc::pixel_format::yuv420p);
+    crop_vc.set_crop(33, 17, 64, 48);
+    ASSERT_TRUE(crop_vc.open(video_path));
+    ASSERT_EQ(crop_vc.get_crop(), std::make_tuple(32, 16, 64, 48));
+    ASSERT_EQ(crop_vc.get_frame_size(), std::make_tuple(64, 48));
+    ASSERT_EQ(crop_vc.get_frame_size_in_bytes().value(), 64 * 48 * 3 / 2);
+    uint8_t* cropped = nullptr;
+    ASSERT_TRUE(crop_vc.read(&cropped));
+
+    for (int y = 0; y < 48; ++y)
+        ASSERT_TRUE(std::equal(cropped + y * 64, cropped + (y + 1) * 64, full_frame.begin() + (16 + y) * w + 32));
+
+    // Crop combined with resize, clipped to the frame.
+    crop_vc.set_output_pixel_format(vc::pixel_format::bgr24);
+    crop_vc.set_crop(w - 64, h - 64, 128, 128);
+    crop_vc.set_output_size(32, 32);
+    ASSERT_TRUE(crop_vc.open(video_path));
+    ASSERT_EQ(crop_vc.get_crop(), std::make_tuple(w - 64, h - 64, 64, 64));
+    ASSERT_EQ(crop_vc.get_frame_size_in_bytes().value(), 32 * 32 * 3);
+    ASSERT_TRUE(crop_vc.read(&cropped));
+
+    crop_vc.set_crop(w, h, 64, 64);
+    ASSERT_FALSE(crop_vc.open(video_path));
+    ASSERT_FALSE(crop_vc.is_opened());
+
+    // Failed open leaves a clean capture behind (contexts freed, checked by the sanitizers builds): next open works.
+    crop_vc.set_crop(0, 0, 64, 64);
+    ASSERT_TRUE(crop_vc.open(video_path));
+    ASSERT_TRUE(crop_vc.read(&cropped));
+}
+
+TEST_F(video_capture_test, seek)
+{ 
+    ASSERT_FALSE(vc->seek(0));
+
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    std::vector<double> timestamps;
+    while (vc->read(&frame))
+        timestamps.push_back(frame.pts);
+    ASSERT_GT(timestamps.size(), 30);
+
+    // Accurate seeks land on the exact frame, also backwards and after end of stream.
+    for (int64_t index : { 20, 5, 30, 0 })
+    {
+        ASSERT_TRUE(vc->seek(index));
+        ASSERT_TRUE(vc->read(&frame));
+        ASSERT_DOUBLE_EQ(frame.pts, timestamps[index]);
+        ASSERT_TRUE(vc->read(&frame));
+        ASSERT_DOUBLE_EQ(frame.pts, timestamps[index + 1]);
+    }
+
+    const auto timestamp = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timestamps[25]));
+    ASSERT_TRUE(vc->seek(timestamp));
+    vc::decoded_frame decoded;
+    ASSERT_TRUE(vc->read(&decoded));
+    ASSERT_DOUBLE_EQ(decoded.get_pts(), timestamps[25]);
+
+    // Fast seeks stop at the previous keyframe.
+    ASSERT_TRUE(vc->seek(20, vc::seek_mode::fast));
+    ASSERT_TRUE(vc->read(&frame));
+    ASSERT_LE(frame.pts, timestamps[20]);
+
+    ASSERT_FALSE(vc->seek(static_cast<int64_t>(timestamps.size()) + 100));
+    ASSERT_FALSE(vc->seek(-1));
+}
+
+TEST_F(video_capture_test, packet_index)
+{ 
+    const auto index_path = std::string("testsrc_10sec_4fps.vcidx");
+    ASSERT_FALSE(vc->build_index(index_path));
+
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    ASSERT_FALSE(vc->has_index());
+    ASSERT_EQ(vc->get_keyframe_index(0), std::nullopt);
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    std::vector<double> timestamps;
+    while (vc->read(&frame))
+        timestamps.push_back(frame.pts);
+
+    // Built from the capture's own context, then rewound: reading starts over from the first frame.
+    ASSERT_TRUE(vc->build_index(index_path));
+    ASSERT_TRUE(vc->has_index());
+    ASSERT_EQ(vc->get_frame_count().value(), static_cast<int>(timestamps.size()));
+    ASSERT_TRUE(vc->read(&frame));
+    ASSERT_DOUBLE_EQ(frame.pts, timestamps[0]);
+
+    // Group of pictures lookups: keyframe at or before every frame, the first frame is always a keyframe.
+    ASSERT_EQ(vc->get_keyframe_index(0), 0);
+    for (int64_t i = 1; i < static_cast<int64_t>(timestamps.size()); ++i)
+    {
+        const auto keyframe = vc->get_keyframe_index(i).value();
+        ASSERT_LE(keyframe, i);
+        ASSERT_GE(keyframe, vc->get_keyframe_index(i - 1).value());
+    }
+    ASSERT_EQ(vc->get_keyframe_index(static_cast<int64_t>(timestamps.size())), std::nullopt);
+
+    for (int64_t index : { 20, 5, 30 })
+    {
+        ASSERT_TRUE(vc->seek(index));
+        ASSERT_TRUE(vc->read(&frame));
+        ASSERT_DOUBLE_EQ(frame.pts, timestamps[index]);
+    }
+    ASSERT_FALSE(vc->seek(static_cast<int64_t>(timestamps.size())));
+
+    // Sidecar survives reopening, but only matches the video it was built from.
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    ASSERT_FALSE(vc->has_index());
+    ASSERT_TRUE(vc->load_index(index_path));
+    ASSERT_EQ(vc->get_frame_count().value(), static_cast<int>(timestamps.size()));
+
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_6fps.mkv"));
+    ASSERT_FALSE(vc->load_index(index_path));
+    ASSERT_FALSE(vc->has_index());
+
+    // Header fields patched in place (layout: fingerprint at byte 40, entry count at byte 48).
+    const auto patch_index = [&index_path](std::streamoff offset, uint64_t value) {
+        std::fstream file(index_path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    // Content changed, same size: fingerprint mismatch.
+    std::ifstream index_file(index_path, std::ios::binary);
+    const std::vector<char> index_data{ std::istreambuf_iterator<char>(index_file), std::istreambuf_iterator<char>() };
+    index_file.close();
+    uint64_t fingerprint = 0;
+    std::memcpy(&fingerprint, index_data.data() + 40, sizeof(fingerprint));
+    patch_index(40, fingerprint + 1);
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    ASSERT_FALSE(vc->load_index(index_path));
+
+    // Corrupted count whose size in bytes wraps around to the actual file size.
+    patch_index(40, fingerprint);
+    ASSERT_TRUE(vc->load_index(index_path));
+    patch_index(48, timestamps.size() + (uint64_t{ 1 } << 59));
+    ASSERT_FALSE(vc->load_index(index_path));
+
+    vc->release();
+    std::remove(index_path.c_str());
+}
+
+TEST_F(video_capture_test, keyframes_only)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    ASSERT_TRUE(vc->open(video_path));
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    std::vector<double> timestamps;
+    while (vc->read(&frame))
+        timestamps.push_back(frame.pts);
+
+    // Every frame returned is one of the regular frames, starting from the first one (always a keyframe).
+    vc->set_keyframes_only(true);
+    ASSERT_TRUE(vc->open(video_path));
+    ASSERT_TRUE(vc->is_keyframes_only());
+    std::vector<double> keyframe_timestamps;
+    while (vc->read(&frame))
+        keyframe_timestamps.push_back(frame.pts);
+
+    ASSERT_FALSE(keyframe_timestamps.empty());
+    ASSERT_LT(keyframe_timestamps.size(), timestamps.size());
+    ASSERT_DOUBLE_EQ(keyframe_timestamps.front(), timestamps.front());
+    for (auto pts : keyframe_timestamps)
+        ASSERT_NE(std::find(timestamps.begin(), timestamps.end(), pts), timestamps.end());
+
+    // Same selection through the decode pipeline.
+    ASSERT_TRUE(vc->open(video_path));
+    ASSERT_TRUE(vc->start());
+    size_t count = 0;
+    while (vc->read(&frame))
+        ++count;
+    vc->stop();
+    ASSERT_EQ(count, keyframe_timestamps.size());
+}
+
+TEST_F(video_capture_test, decimation)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    ASSERT_TRUE(vc->open(video_path));
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    std::vector<double> timestamps;
+    while (vc->read(&frame))
+        timestamps.push_back(frame.pts);
+
+    // Keep every N: exactly frames 0, N, 2N, ...
+    vc->set_keep_every(3);
+    ASSERT_TRUE(vc->open(video_path));
+    size_t index = 0;
+    while (vc->read(&frame))
+    {
+        ASSERT_LT(index, timestamps.size());
+        ASSERT_DOUBLE_EQ(frame.pts, timestamps[index]);
+        index += 3;
+    }
+    ASSERT_EQ(index, (timestamps.size() + 2) / 3 * 3);
+
+    // Target frame rate: 5 out of 30 fps, kept frames are evenly spaced.
+    vc->set_target_fps(5.0);
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_30fps.mkv"));
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    std::vector<double> decimated_timestamps;
+    while (vc->read(&frame))
+        decimated_timestamps.push_back(frame.pts);
+
+    ASSERT_GE(decimated_timestamps.size(), 45);
+    ASSERT_LE(decimated_timestamps.size(), 51);
+    for (size_t i = 1; i < decimated_timestamps.size(); ++i)
+        ASSERT_GE(decimated_timestamps[i] - decimated_timestamps[i - 1], 0.2 - 0.5 / 30.0);
+
+    // Same selection through the decode pipeline.
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_30fps.mkv"));
+    ASSERT_TRUE(vc->start());
+    size_t count = 0;
+    while (vc->read(&frame))
+        ++count;
+    vc->stop();
+    ASSERT_EQ(count, decimated_timestamps.size());
+
+    vc->set_target_fps(0.0);
+    ASSERT_TRUE(vc->open(video_path));
+    count = 0;
+    while (vc->read(&frame))
+        ++count;
+    ASSERT_EQ(count, timestamps.size());
+}
+
+TEST_F(video_capture_test, decode_threading)
+{ 
+    ASSERT_EQ(vc->get_decode_threading(), std::nullopt);
+
+    vc->set_decode_threading(vc::decode_threading::none);
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    ASSERT_EQ(vc->get_decode_threading(), std::make_tuple(vc::decode_threading::none, 1));
+
+    vc->set_decode_threading(vc::decode_threading::slice, 2);
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    const auto [threading, thread_count] = vc->get_decode_threading().value();
+    ASSERT_NE(threading, vc::decode_threading::frame);
+    ASSERT_LE(thread_count, 2);
+
+    uint8_t* data = nullptr;
+    ASSERT_TRUE(vc->read(&data));
+}
+
+TEST_F(video_capture_test, sliced_conversion)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    ASSERT_TRUE(vc->open(video_path));
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    ASSERT_TRUE(vc->read(&frame));
+
+    vc::video_capture sliced_vc;
+    sliced_vc.set_conversion_threads(4);
+    ASSERT_TRUE(sliced_vc.open(video_path));
+    vc::raw_frame sliced_frame;
+    sliced_frame.data.resize(sliced_vc.get_frame_size_in_bytes().value());
+    ASSERT_TRUE(sliced_vc.read(&sliced_frame));
+
+    // Slices are converted independently: only rows at slice borders may differ because of chroma interpolation.
+    ASSERT_EQ(frame.data.size(), sliced_frame.data.size());
+    double total_diff = 0.0;
+    for (size_t i = 0; i < frame.data.size(); ++i)
+        total_diff += std::abs(static_cast<int>(frame.data[i]) - static_cast<int>(sliced_frame.data[i]));
+    ASSERT_LT(total_diff / frame.data.size(), 1.0);
+}
+
+TEST_F(video_capture_test, sliced_conversion_resize)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    ASSERT_TRUE(vc->open(video_path));
+    const auto [w, h] = vc->get_frame_size().value();
+
+    // Horizontal resize is sliced, vertical resize (non integer ratio, tiny source bands) is converted as a whole image.
+    for (const auto& [dst_w, dst_h] : { std::make_tuple(w * 3 / 2, h), std::make_tuple(w, h * 3 / 2), std::make_tuple(w / 2, h * 9 / 2) })
+    {
+        vc->set_output_size(dst_w, dst_h);
+        ASSERT_TRUE(vc->open(video_path));
+        vc::raw_frame frame;
+        frame.data.resize(vc->get_frame_size_in_bytes().value());
+        ASSERT_TRUE(vc->read(&frame));
+
+        vc::video_capture sliced_vc;
+        sliced_vc.set_output_size(dst_w, dst_h);
+        sliced_vc.set_conversion_threads(8);
+        ASSERT_TRUE(sliced_vc.open(video_path));
+        vc::raw_frame sliced_frame;
+        sliced_frame.data.resize(sliced_vc.get_frame_size_in_bytes().value());
+        ASSERT_TRUE(sliced_vc.read(&sliced_frame));
+
+        ASSERT_EQ(frame.data.size(), sliced_frame.data.size());
+        double total_diff = 0.0;
+        for (size_t i = 0; i < frame.data.size(); ++i)
+            total_diff += std::abs(static_cast<int>(frame.data[i]) - static_cast<int>(sliced_frame.data[i]));
+
+        if (dst_h == h)
+            ASSERT_LT(total_diff / frame.data.size(), 1.0);
+        else
+            ASSERT_EQ(total_diff, 0.0);
+    }
+}
+
+TEST_F(video_capture_test, native_conversion)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    for (auto format : { vc::pixel_format::bgr24, vc::pixel_format::rgb24, vc::pixel_format::rgba })
+    {
+        vc->set_output_pixel_format(format);
+        vc->set_conversion_backend(vc::conversion_backend::swscale);
+        ASSERT_TRUE(vc->open(video_path));
+        vc::raw_frame frame;
+        frame.data.resize(vc->get_frame_size_in_bytes().value());
+        ASSERT_TRUE(vc->read(&frame));
+
+        vc::video_capture native_vc;
+        native_vc.set_output_pixel_format(format);
+        native_vc.set_conversion_backend(vc::conversion_backend::native);
+        ASSERT_EQ(native_vc.get_conversion_backend(), vc::conversion_backend::native);
+        ASSERT_TRUE(native_vc.open(video_path));
+        vc::raw_frame native_frame;
+        native_frame.data.resize(native_vc.get_frame_size_in_bytes().value());
+        ASSERT_TRUE(native_vc.read(&native_frame));
+
+        // Different fixed point rounding: checksums and pixels must match within a couple of levels, not bit-exactly.
+        ASSERT_EQ(frame.data.size(), native_frame.data.size());
+        int64_t checksum = 0;
+        int64_t native_checksum = 0;
+        int max_diff = 0;
+        for (size_t i = 0; i < frame.data.size(); ++i)
+        {
+            checksum += frame.data[i];
+            native_checksum += native_frame.data[i];
+            max_diff = std::max(max_diff, std::abs(static_cast<int>(frame.data[i]) - static_cast<int>(native_frame.data[i])));
+        }
+        ASSERT_LT(std::abs(checksum - native_checksum) / static_cast<double>(frame.data.size()), 1.0);
+        ASSERT_LE(max_diff, 8);
+    }
+}
+
+TEST_F(video_capture_test, read_batch)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    vc::video_capture reference_vc;
+    reference_vc.set_output_pixel_format(vc::pixel_format::rgb24);
+    ASSERT_TRUE(reference_vc.open(video_path));
+    const auto frame_size = static_cast<size_t>(reference_vc.get_frame_size_in_bytes().value());
+    const auto [w, h] = reference_vc.get_frame_size().value();
+
+    std::vector<vc::raw_frame> reference_frames;
+    vc::raw_frame frame;
+    frame.data.resize(frame_size);
+    while (reference_vc.read(&frame))
+        reference_frames.push_back(frame);
+
+    // NHWC: frames are laid out back to back, exactly as read() returns them. Last batch is a partial one.
+    constexpr size_t batch_size = 16;
+    std::vector<uint8_t> batch(batch_size * frame_size);
+    std::vector<double> pts(batch_size);
+    vc->set_output_pixel_format(vc::pixel_format::rgb24);
+    ASSERT_TRUE(vc->open(video_path));
+
+    size_t frame_index = 0;
+    while (auto count = vc->read_batch(batch_size, batch.data(), pts.data()))
+    {
+        for (size_t i = 0; i < count; ++i, ++frame_index)
+        {
+            ASSERT_LT(frame_index, reference_frames.size());
+            ASSERT_EQ(pts[i], reference_frames[frame_index].pts);
+            ASSERT_TRUE(std::equal(reference_frames[frame_index].data.begin(), reference_frames[frame_index].data.end(), batch.begin() + i * frame_size));
+        }
+    }
+    ASSERT_EQ(frame_index, reference_frames.size());
+
+    // NCHW: R, G and B planes. Planar conversion interpolates chroma differently from the packed one, so compare on average.
+    ASSERT_TRUE(vc->seek(int64_t{ 0 }));
+    ASSERT_EQ(vc->read_batch(2, batch.data(), pts.data(), vc::tensor_layout::nchw), 2);
+    const size_t plane_size = w * h;
+    int64_t total_diff = 0;
+    for (size_t i = 0; i < 2; ++i)
+        for (size_t c = 0; c < 3; ++c)
+            for (size_t p = 0; p < plane_size; ++p)
+            {
+                const int value = batch[i * frame_size + c * plane_size + p];
+                const int reference = reference_frames[i].data[p * 3 + c];
+                total_diff += std::abs(value - reference);
+            }
+    ASSERT_LT(total_diff / static_cast<double>(2 * frame_size), 2.0);
+    ASSERT_EQ(pts[0], reference_frames[0].pts);
+
+    // Planar layout of YUV outputs is not a tensor.
+    vc->release();
+    vc->set_output_pixel_format(vc::pixel_format::yuv420p);
+    ASSERT_TRUE(vc->open(video_path));
+    ASSERT_EQ(vc->read_batch(2, batch.data(), pts.data(), vc::tensor_layout::nchw), 0);
+}
+
+TEST_F(video_capture_test, float_output)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    vc::video_capture reference_vc;
+    reference_vc.set_output_pixel_format(vc::pixel_format::rgb24);
+    ASSERT_TRUE(reference_vc.open(video_path));
+    const auto [w, h] = reference_vc.get_frame_size().value();
+    vc::raw_frame reference_frame;
+    reference_frame.data.resize(reference_vc.get_frame_size_in_bytes().value());
+    ASSERT_TRUE(reference_vc.read(&reference_frame));
+
+    // Only RGB and BGR channel orders are available.
+    std::vector<float> tensor(3 * w * h);
+    vc->set_output_pixel_format(vc::pixel_format::gray8);
+    ASSERT_TRUE(vc->open(video_path));
+    ASSERT_FALSE(vc->read(tensor.data()));
+
+    // Same geometry of the reference: values only differ by chroma interpolation and rounding.
+    const std::array<float, 3> mean = { 0.485f, 0.456f, 0.406f };
+    const std::array<float, 3> stddev = { 0.229f, 0.224f, 0.225f };
+    vc->set_output_pixel_format(vc::pixel_format::rgb24);
+    vc->set_normalization(mean, stddev);
+    ASSERT_TRUE(vc->open(video_path));
+    ASSERT_TRUE(vc->read(tensor.data()));
+    ASSERT_EQ(vc->get_letterbox_rect().value(), std::make_tuple(0, 0, w, h));
+
+    const size_t plane_size = w * h;
+    double total_diff = 0.0;
+    for (size_t c = 0; c < 3; ++c)
+        for (size_t p = 0; p < plane_size; ++p)
+        {
+            const float pixel = (tensor[c * plane_size + p] * stddev[c] + mean[c]) * 255.0f;
+            total_diff += std::abs(pixel - reference_frame.data[p * 3 + c]);
+        }
+    ASSERT_LT(total_diff / (3 * plane_size), 2.0);
+
+    // Letterbox into a square: image keeps its aspect ratio, bands hold the normalized padding value.
+    const int size = std::max(w, h);
+    vc->set_output_size(size, size);
+    vc->set_letterbox(true, 114);
+    ASSERT_TRUE(vc->open(video_path));
+    const auto [x, y, content_w, content_h] = vc->get_letterbox_rect().value();
+    ASSERT_EQ(content_w, w);
+    ASSERT_EQ(content_h, h);
+    ASSERT_EQ(x, (size - w) / 2);
+    ASSERT_EQ(y, (size - h) / 2);
+
+    tensor.resize(3 * size * size);
+    ASSERT_TRUE(vc->read(tensor.data()));
+    for (size_t c = 0; c < 3; ++c)
+    {
+        const float pad = (114.0f / 255.0f - mean[c]) / stddev[c];
+        ASSERT_FLOAT_EQ(tensor[c * size * size], pad);
+        ASSERT_FLOAT_EQ(tensor[(c + 1) * size * size - 1], pad);
+    }
+}
+
+TEST_F(video_capture_test, latency_profile)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_15fps.mkv";
+    std::vector<double> timestamps[2];
+    for (auto profile : { vc::latency_profile::standard, vc::latency_profile::low_latency })
+    {
+        vc->set_latency_profile(profile);
+        ASSERT_EQ(vc->get_latency_profile(), profile);
+        ASSERT_TRUE(vc->open(video_path));
+        ASSERT_NE(vc->get_open_time(), std::nullopt);
+        ASSERT_EQ(vc->get_first_frame_latency(), std::nullopt);
+
+        // First frame latency starts at the first read: the time the capture sits idle after open() is not part of it.
+        const auto idle_time = std::chrono::milliseconds(300);
+        std::this_thread::sleep_for(idle_time);
+
+        vc::raw_frame frame;
+        frame.data.resize(vc->get_frame_size_in_bytes().value());
+        while (vc->read(&frame))
+            timestamps[static_cast<int>(profile)].push_back(frame.pts);
+
+        ASSERT_NE(vc->get_first_frame_latency(), std::nullopt);
+        ASSERT_LT(vc->get_first_frame_latency().value(), idle_time);
+        log("Latency profile", static_cast<int>(profile),
+            "open time:", std::chrono::duration_cast<std::chrono::microseconds>(vc->get_open_time().value()).count(), "us",
+            "first frame latency:", std::chrono::duration_cast<std::chrono::microseconds>(vc->get_first_frame_latency().value()).count(), "us");
+    }
+
+    // Shorter probing and no buffering must not change what gets decoded, nor its order.
+    ASSERT_FALSE(timestamps[0].empty());
+    ASSERT_EQ(timestamps[0], timestamps[1]);
+}
+
+TEST_F(video_capture_test, latency_profile_demuxer_options)
+{ 
+    // Effective demuxer settings are logged on open: the profile defaults must reach the format context, user options override them.
+    std::vector<std::string> messages;
+    vc->set_log_callback([&messages](const std::string& s) { messages.push_back(s); }, vc::log_level::info);
+    const auto get_demuxer_settings = [&messages]() {
+        const auto it = std::find_if(messages.begin(), messages.end(), [](const std::string& s) { return s.rfind("Demuxer:", 0) == 0; });
+        return it != messages.end() ? *it : std::string();
+    };
+
+    const auto video_path = test_data_directory + "testsrc_10sec_15fps.mkv";
+    ASSERT_TRUE(vc->open(video_path));
+    ASSERT_NE(get_demuxer_settings().find("nobuffer no"), std::string::npos);
+
+    messages.clear();
+    vc->set_latency_profile(vc::latency_profile::low_latency);
+    ASSERT_TRUE(vc->open(video_path));
+    const auto settings = get_demuxer_settings();
+    ASSERT_NE(settings.find("nobuffer yes"), std::string::npos);
+    ASSERT_NE(settings.find("probesize 32768"), std::string::npos);
+    ASSERT_NE(settings.find("analyzeduration 100000"), std::string::npos);
+    ASSERT_NE(settings.find("max_delay 0"), std::string::npos);
+
+    messages.clear();
+    ASSERT_TRUE(vc->open(video_path, { { "probesize", "65536" } }));
+    ASSERT_NE(get_demuxer_settings().find("probesize 65536"), std::string::npos);
+
+    // Frames still come out of the nobuffer path.
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    ASSERT_TRUE(vc->read(&frame));
+    vc->set_log_callback([](const std::string&) { }, vc::log_level::info);
+}
+
+// Live source served locally, e.g.:
+//   ffmpeg -re -stream_loop -1 -i testsrc_30sec_30fps.mkv -c copy -f mpegts udp://127.0.0.1:5000
+//   VCPP_TEST_LIVE_URL=udp://127.0.0.1:5000 ./video_capture_tests
+TEST_F(video_capture_test, latency_profile_live_stream)
+{ 
+    const char* url = std::getenv("VCPP_TEST_LIVE_URL");
+    if (!url)
+        GTEST_SKIP() << "VCPP_TEST_LIVE_URL not set";
+
+    std::chrono::steady_clock::duration latency[2];
+    for (auto profile : { vc::latency_profile::standard, vc::latency_profile::low_latency })
+    {
+        vc->set_latency_profile(profile);
+        ASSERT_TRUE(vc->open(url));
+        vc::raw_frame frame;
+        frame.data.resize(vc->get_frame_size_in_bytes().value());
+        ASSERT_TRUE(vc->read(&frame));
+        latency[static_cast<int>(profile)] = vc->get_first_frame_latency().value();
+        vc->release();
+
+        log("Latency profile", static_cast<int>(profile), "first frame latency:",
+            std::chrono::duration_cast<std::chrono::milliseconds>(latency[static_cast<int>(profile)]).count(), "ms");
+    }
+
+    ASSERT_LT(latency[1], latency[0]);
+}
+
+TEST_F(video_capture_test, open_memory)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    const auto read_pts = [this]() {
+        std::vector<double> pts;
+        vc::raw_frame frame;
+        frame.data.resize(vc->get_frame_size_in_bytes().value());
+        while (vc->read(&frame))
+            pts.push_back(frame.pts);
+        return pts;
+    };
+
+    ASSERT_TRUE(vc->open(video_path));
+    const auto expected = read_pts();
+    ASSERT_FALSE(expected.empty());
+
+    std::ifstream file(video_path, std::ios::binary);
+    const std::vector<uint8_t> blob{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    ASSERT_TRUE(vc->open(blob.data(), blob.size()));
+    ASSERT_EQ(vc->get_frame_count().value(), static_cast<int>(expected.size()));
+    ASSERT_EQ(read_pts(), expected);
+
+    // Memory inputs are seekable.
+    ASSERT_TRUE(vc->seek(10));
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    ASSERT_TRUE(vc->read(&frame));
+    ASSERT_DOUBLE_EQ(frame.pts, expected[10]);
+
+    // No file behind a memory input: the sidecar index needs an explicit path.
+    const auto index_path = std::string("open_memory.vcidx");
+    ASSERT_FALSE(vc->build_index());
+    ASSERT_TRUE(vc->build_index(index_path));
+    ASSERT_EQ(vc->get_frame_count().value(), static_cast<int>(expected.size()));
+    ASSERT_EQ(read_pts(), expected);
+
+    // Same content through the mapped file: the index matches it.
+    ASSERT_TRUE(vc->open_mapped(video_path));
+    ASSERT_TRUE(vc->load_index(index_path));
+    ASSERT_EQ(read_pts(), expected);
+
+    ASSERT_FALSE(vc->open(blob.data(), 0));
+    ASSERT_FALSE(vc->open(blob.data(), 64));
+    ASSERT_FALSE(vc->open_mapped(test_data_directory + "not_a_file.mkv"));
+    std::remove(index_path.c_str());
+}
+
+TEST_F(video_capture_test, open_options)
+{ 
+    const auto video_path = test_data_directory + "testsrc_10sec_4fps.mkv";
+    const vc::video_capture::options_t format_options = { { "probesize", "5000000" }, { "fpsprobesize", "2" }, { "not_an_option", "1" } };
+    const vc::video_capture::options_t codec_options = { { "skip_loop_filter", "all" }, { "threads", "2" }, { "not_an_option", "2" } };
+    ASSERT_TRUE(vc->open(video_path, format_options, codec_options));
+
+    // Only the options FFmpeg did not consume are reported back.
+    const vc::video_capture::options_t unused_format_options = { { "not_an_option", "1" } };
+    const vc::video_capture::options_t unused_codec_options = { { "not_an_option", "2" } };
+    ASSERT_EQ(vc->get_unused_format_options(), unused_format_options);
+    ASSERT_EQ(vc->get_unused_codec_options(), unused_codec_options);
+
+    size_t count = 0;
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    while (vc->read(&frame))
+        ++count;
+
+    // Defaults are restored on the next open, the very same frames are decoded.
+    ASSERT_TRUE(vc->open(video_path));
+    ASSERT_TRUE(vc->get_unused_format_options().empty());
+    ASSERT_TRUE(vc->get_unused_codec_options().empty());
+    size_t default_count = 0;
+    while (vc->read(&frame))
+        ++default_count;
+    ASSERT_GT(count, 0);
+    ASSERT_EQ(count, default_count);
+
+    // Invalid values of known options make open() fail.
+    ASSERT_FALSE(vc->open(video_path, { { "probesize", "not_a_number" } }));
+}
+
+TEST_F(video_capture_test, stats)
+{ 
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    uint64_t n_frames = 0;
+    while (vc->read(&frame))
+        ++n_frames;
+
+    const auto s = vc->get_stats();
+    if (!s.is_enabled)
+    {
+        // Library built with VCPP_STATS=OFF.
+        ASSERT_EQ(s.frames_decoded, 0);
+        ASSERT_EQ(s.read.count, 0);
+        return;
+    }
+
+    ASSERT_EQ(s.frames_decoded, n_frames);
+    ASSERT_EQ(s.convert.count, n_frames);
+    ASSERT_EQ(s.transfer.count, 0);
+    ASSERT_EQ(s.decode_errors, 0);
+    ASSERT_GE(s.packets_read, n_frames);
+    ASSERT_GT(s.bytes_read, s.packets_read);
+    ASSERT_GE(s.read.count, s.packets_read);
+    ASSERT_GE(s.decode.count, s.packets_read);
+    ASSERT_GT(s.elapsed, s.decode.total);
+
+    for (const auto& stage : { s.read, s.decode, s.convert })
+    {
+        ASSERT_LE(stage.min, stage.p50);
+        ASSERT_LE(stage.p50, stage.p90);
+        ASSERT_LE(stage.p90, stage.p99);
+        ASSERT_LE(stage.p99, stage.max);
+        ASSERT_LE(stage.max, stage.total);
+    }
+
+    log("read p50:", s.read.p50.count(), "ns", "decode p50:", s.decode.p50.count(), "ns", "convert p50:", s.convert.p50.count(), "ns");
+
+    vc->reset_stats();
+    ASSERT_EQ(vc->get_stats().frames_decoded, 0);
+    ASSERT_EQ(vc->get_stats().convert.count, 0);
+}
+
+TEST_F(video_capture_test, read_decoded_frame)
+{ 
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    const auto [w, h] = vc->get_frame_size().value();
+
+    vc::decoded_frame frame;
+    ASSERT_TRUE(vc->read(&frame));
+    ASSERT_TRUE(frame.is_valid());
+    ASSERT_EQ(frame.get_width(), w);
+    ASSERT_EQ(frame.get_height(), h);
+    ASSERT_NE(frame.data(0), nullptr);
+    ASSERT_GE(frame.linesize(0), w);
+
+    vc::decoded_frame moved_frame = std::move(frame);
+    ASSERT_FALSE(frame.is_valid());
+    ASSERT_TRUE(moved_frame.is_valid());
+
+    moved_frame.release();
+    ASSERT_FALSE(moved_frame.is_valid());
+}
+
+TEST_F(video_capture_test, decode_pipeline)
+{ 
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_4fps.mkv"));
+    const auto frame_count = vc->get_frame_count().value();
+
+    ASSERT_TRUE(vc->start());
+    ASSERT_TRUE(vc->is_running());
+
+    uint8_t* data = nullptr;
+    ASSERT_FALSE(vc->read(&data));
+
+    vc::raw_frame frame;
+    int n_frames = 0;
+    while(vc->read(&frame))
+    {
+        ASSERT_EQ(frame.data.size(), vc->get_frame_size_in_bytes().value());
+        ++n_frames;
+    }
+
+    vc->stop();
+    ASSERT_FALSE(vc->is_running());
+    ASSERT_EQ(n_frames, frame_count);
+}
+
+TEST_F(video_capture_test, decode_pipeline_keep_latest)
+{ 
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_30fps.mkv"));
+    const auto frame_count = vc->get_frame_count().value();
+    ASSERT_EQ(vc->get_dropped_frames(), std::nullopt);
+    ASSERT_TRUE(vc->start(4, vc::overflow_policy::keep_latest));
+
+    // Slow consumer: decoding is never stalled, stale frames are replaced and the last one is always delivered.
+    vc::raw_frame frame;
+    frame.data.resize(vc->get_frame_size_in_bytes().value());
+    double last_pts = -1.0;
+    int n_frames = 0;
+    while (vc->read(&frame))
+    {
+        ASSERT_GT(frame.pts, last_pts);
+        last_pts = frame.pts;
+        ++n_frames;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    const auto dropped = vc->get_dropped_frames().value();
+    ASSERT_GT(dropped, 0);
+    ASSERT_EQ(n_frames + dropped, static_cast<size_t>(frame_count));
+    vc->stop();
+}
+
+TEST_F(video_capture_test, decode_pipeline_stop_while_running)
+{ 
+    ASSERT_TRUE(vc->open(test_data_directory + "testsrc_10sec_30fps.mkv"));
+    ASSERT_TRUE(vc->start(2));
+
+    vc::raw_frame frame;
+    ASSERT_TRUE(vc->read(&frame));
+    vc->stop();
+
+    // Serial reads are available again once the pipeline is stopped.
+    uint8_t* data = nullptr;
+    ASSERT_TRUE(vc->read(&data));
+}
+
 
 // T EST_F(video_capture_test, all_callback){ }
 // T EST_F(video_capture_test, open_default_decode){ }
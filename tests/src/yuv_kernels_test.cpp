@@ -0,0 +1,81 @@
+#include <yuv_kernels_test.hpp>
+#include <yuv_to_rgb.hpp>
+
+#include <random>
+#include <vector>
+
+namespace vc::test
+{
+namespace
+{
+    // Every kernel of the set against the scalar one: random rows, widths covering each SIMD tail and exact size buffers,
+    // so that a read or a write past the end of the row shows up under sanitizers.
+    void compare_with_scalar(const vc::yuv_kernels& kernels)
+    {
+        const auto& scalar = vc::get_yuv_kernels_scalar();
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> byte(0, 255);
+
+        std::vector<int> widths;
+        for (int width = 1; width <= 67; ++width)
+            widths.push_back(width);
+        widths.insert(widths.end(), { 127, 129, 641, 1279, 1921 });
+
+        for (auto matrix : { vc::yuv_matrix::bt601, vc::yuv_matrix::bt709 })
+        for (auto full_range : { false, true })
+        for (auto layout : { vc::rgb_layout::bgr24, vc::rgb_layout::rgb24, vc::rgb_layout::rgba })
+        for (auto is_nv12 : { false, true })
+        for (auto width : widths)
+        {
+            const auto c = vc::get_yuv_coefficients(matrix, full_range);
+            const int chroma_width = (width + 1) / 2;
+            const int bpp = layout == vc::rgb_layout::rgba ? 4 : 3;
+
+            std::vector<uint8_t> y(width), u(is_nv12 ? 2 * chroma_width : chroma_width), v(chroma_width);
+            for (auto* plane : { &y, &u, &v })
+                for (auto& value : *plane)
+                    value = static_cast<uint8_t>(byte(rng));
+
+            std::vector<uint8_t> expected(width * bpp), actual(width * bpp);
+            const int i = static_cast<int>(layout);
+            if (is_nv12)
+            {
+                scalar.nv12[i](y.data(), u.data(), nullptr, expected.data(), width, c);
+                kernels.nv12[i](y.data(), u.data(), nullptr, actual.data(), width, c);
+            }
+            else
+            {
+                scalar.planar[i](y.data(), u.data(), v.data(), expected.data(), width, c);
+                kernels.planar[i](y.data(), u.data(), v.data(), actual.data(), width, c);
+            }
+
+            ASSERT_EQ(actual, expected) << kernels.name << (is_nv12 ? " nv12" : " planar") << " layout " << i
+                << " width " << width << (matrix == vc::yuv_matrix::bt709 ? " bt709" : " bt601") << (full_range ? " full" : " limited");
+        }
+    }
+}
+
+TEST_F(yuv_kernels_test, sse41_matches_scalar)
+{
+    const auto* kernels = vc::get_yuv_kernels_sse41();
+    if (!kernels || !vc::cpu_has_sse41())
+        GTEST_SKIP() << "SSE4.1 kernels not available";
+
+    compare_with_scalar(*kernels);
+}
+
+TEST_F(yuv_kernels_test, avx2_matches_scalar)
+{
+    const auto* kernels = vc::get_yuv_kernels_avx2();
+    if (!kernels || !vc::cpu_has_avx2())
+        GTEST_SKIP() << "AVX2 kernels not available";
+
+    compare_with_scalar(*kernels);
+}
+
+TEST_F(yuv_kernels_test, dispatch_matches_scalar)
+{
+    compare_with_scalar(vc::get_yuv_kernels());
+}
+
+}
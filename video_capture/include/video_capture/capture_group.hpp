@@ -0,0 +1,58 @@
+#pragma once
+
+#include "api.hpp"
+#include "video_capture.hpp"
+
+#include <string>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <atomic>
+
+namespace vc
+{
+struct raw_frame;
+
+class API_VIDEO_CAPTURE capture_group
+{
+public:
+    // A thread count of 0 uses one worker per core. Every source can have up to queue_size frames waiting in its output queue.
+    // Each source also gets its own demux thread, blocked on its input most of the time: workers only decode and convert.
+    explicit capture_group(size_t thread_count = 0, size_t output_queues = 1, size_t queue_size = 4) noexcept;
+    ~capture_group() noexcept;
+
+    using configure_callback_t = std::function<void(video_capture&)>;
+    int add_source(const std::string& video_path, size_t output_queue = 0, decode_support decode_preference = decode_support::none, const configure_callback_t& configure = {});
+
+    bool start();
+    void stop();
+    bool is_running() const;
+    bool read(raw_frame* frame, int* source_id, size_t output_queue = 0);
+
+    auto get_source_count() const -> size_t;
+    auto get_thread_count() const -> size_t;
+    auto get_frame_size(int source_id) const -> std::optional<std::tuple<int, int>>;
+    auto get_frame_size_in_bytes(int source_id) const -> std::optional<int>;
+
+private:
+    void demux(int source_id);
+    void decode(int source_id);
+    void schedule(int source_id);
+    void finish(int source_id);
+
+    size_t _thread_count;
+    size_t _queue_size;
+    std::atomic<bool> _is_running;
+
+    struct source;
+    std::vector<std::unique_ptr<source>> _sources;
+
+    struct output;
+    std::vector<std::unique_ptr<output>> _outputs;
+
+    class work_stealing_pool;
+    std::unique_ptr<work_stealing_pool> _pool;
+};
+
+}
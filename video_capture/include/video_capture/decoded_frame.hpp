@@ -0,0 +1,43 @@
+#pragma once
+
+#include "api.hpp"
+#include "video_capture.hpp"
+
+#include <cstdint>
+#include <optional>
+
+struct AVFrame;
+
+namespace vc
+{
+class API_VIDEO_CAPTURE decoded_frame
+{
+public:
+    explicit decoded_frame() noexcept;
+    ~decoded_frame() noexcept;
+
+    decoded_frame(decoded_frame&& other) noexcept;
+    decoded_frame& operator=(decoded_frame&& other) noexcept;
+    decoded_frame(const decoded_frame&) = delete;
+    decoded_frame& operator=(const decoded_frame&) = delete;
+
+    bool is_valid() const;
+    void release();
+
+    auto data(int plane) const -> const uint8_t*;
+    auto linesize(int plane) const -> int;
+    auto get_planes() const -> int;
+    auto get_width() const -> int;
+    auto get_height() const -> int;
+    auto get_pts() const -> double;
+    auto get_format() const -> std::optional<pixel_format>;
+    auto get_native_format() const -> int;
+
+private:
+    friend class video_capture;
+
+    AVFrame* _frame;
+    double _pts;
+};
+
+}
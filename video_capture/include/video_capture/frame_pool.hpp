@@ -0,0 +1,114 @@
+#pragma once
+
+#include "raw_frame.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+namespace vc
+{
+	class frame_pool
+	{
+	private:
+		struct storage
+		{
+			~storage()
+			{
+				for (auto frame : _frames)
+					delete frame;
+			}
+
+			mutable std::mutex _lock;
+			std::vector<raw_frame *> _frames;
+			size_t _frame_size;
+			size_t _capacity;
+		};
+
+		using guard = std::lock_guard<std::mutex>;
+
+	public:
+		struct recycler
+		{
+			std::shared_ptr<storage> _storage;
+
+			void operator()(raw_frame *frame) const
+			{
+				if (!frame)
+					return;
+
+				if (_storage)
+				{
+					guard g(_storage->_lock);
+					if (_storage->_frames.size() < _storage->_capacity)
+					{
+						_storage->_frames.push_back(frame);
+						return;
+					}
+				}
+
+				delete frame;
+			}
+		};
+
+		using handle = std::unique_ptr<raw_frame, recycler>;
+
+		explicit frame_pool(size_t frame_size, size_t capacity = 8)
+			: _storage{std::make_shared<storage>()}
+		{
+			_storage->_frame_size = frame_size;
+			_storage->_capacity = std::max<size_t>(capacity, 1);
+			_storage->_frames.reserve(_storage->_capacity);
+
+			// Allocate all the buffers upfront: steady state acquire/release cycles never touch the heap.
+			for (size_t i = 0; i < _storage->_capacity; ++i)
+			{
+				auto frame = new raw_frame();
+				frame->data.resize(frame_size);
+				_storage->_frames.push_back(frame);
+			}
+		}
+
+		handle acquire()
+		{
+			raw_frame *frame = nullptr;
+			{
+				guard g(_storage->_lock);
+				if (!_storage->_frames.empty())
+				{
+					frame = _storage->_frames.back();
+					_storage->_frames.pop_back();
+				}
+			}
+
+			// Pool exhausted (consumer is holding more frames than capacity): grow on demand.
+			// Exceeding frames are deleted when released, instead of being given back to the pool.
+			if (!frame)
+				frame = new raw_frame();
+
+			frame->data.resize(_storage->_frame_size);
+			frame->pts = 0.0;
+			return handle(frame, recycler{_storage});
+		}
+
+		size_t get_frame_size() const
+		{
+			return _storage->_frame_size;
+		}
+
+		size_t get_capacity() const
+		{
+			return _storage->_capacity;
+		}
+
+		size_t available() const
+		{
+			guard g(_storage->_lock);
+			return _storage->_frames.size();
+		}
+
+	private:
+		std::shared_ptr<storage> _storage;
+	};
+}
@@ -7,9 +7,15 @@
 #include <deque>
 #include <queue>
 #include <algorithm>
+#include <optional>
 
 namespace vc
 {
+	// What put() does when the queue is full:
+	// block waits for the consumer, drop_newest discards the incoming item, drop_oldest discards the head of the queue
+	// and keep_latest turns the queue into a single slot mailbox that always holds the freshest item.
+	enum class overflow_policy { block, drop_newest, drop_oldest, keep_latest };
+
 	template <typename T>
 	class frame_queue
 	{
@@ -23,17 +29,23 @@ namespace vc
 		size_t _max_size;
 		// std::optional<size_t> _max_size;
 		std::deque<T> _queue;
+		overflow_policy _policy;
+		size_t _dropped;
 		using guard = std::lock_guard<std::mutex>;
 		using unique_guard = std::unique_lock<std::mutex>;
 
 	public:
 		frame_queue()
 			: _max_size{std::numeric_limits<size_t>::max()}
+			, _policy{overflow_policy::block}
+			, _dropped{0}
 		{
 		}
 
-		explicit frame_queue(size_t max_size)
-			: _max_size{std::clamp<size_t>(max_size, 1, std::numeric_limits<size_t>::max())}
+		explicit frame_queue(size_t max_size, overflow_policy policy = overflow_policy::block)
+			: _max_size{policy == overflow_policy::keep_latest ? 1 : std::clamp<size_t>(max_size, 1, std::numeric_limits<size_t>::max())}
+			, _policy{policy}
+			, _dropped{0}
 		{
 		}
 
@@ -55,10 +67,12 @@ namespace vc
 			return _max_size;
 		}
 
+		// Ignored by a keep_latest queue: it stays a single slot mailbox.
 		void set_max_size(size_t cap)
 		{
 			guard g(_lock);
-			_max_size = cap;
+			if (_policy != overflow_policy::keep_latest)
+				_max_size = cap;
 		}
 
 		size_t size() const
@@ -67,19 +81,59 @@ namespace vc
 			return _queue.size();
 		}
 
-		void put(value_type val)
+		overflow_policy get_overflow_policy() const
+		{
+			guard g(_lock);
+			return _policy;
+		}
+
+		// Items discarded by the overflow policy since construction.
+		size_t get_dropped_count() const
+		{
+			guard g(_lock);
+			return _dropped;
+		}
+
+		// Returns false when the item itself got dropped (drop_newest on a full queue).
+		bool put(value_type val)
+		{
+			return put(std::move(val), _policy);
+		}
+
+		// Policy override for a single item, e.g. end of stream markers that must never be dropped.
+		bool put(value_type val, overflow_policy policy)
 		{
 			unique_guard g(_lock);
+			std::optional<value_type> dropped;
 			if (_queue.size() >= _max_size)
-				notFullCond_.wait(g, [=]
-								  { return _queue.size() < _max_size; });
+			{
+				switch (policy)
+				{
+				case overflow_policy::block:
+					notFullCond_.wait(g, [=]
+									  { return _queue.size() < _max_size; });
+					break;
+
+				case overflow_policy::drop_newest:
+					++_dropped;
+					return false;
+
+				case overflow_policy::drop_oldest:
+				case overflow_policy::keep_latest:
+					dropped.emplace(std::move(_queue.front()));
+					_queue.pop_front();
+					++_dropped;
+					break;
+				}
+			}
 			bool wasEmpty = _queue.empty();
 			_queue.emplace_back(std::move(val));
+			g.unlock();
+
+			// Dropped item is released outside of the lock (e.g. a pooled frame going back to its pool).
 			if (wasEmpty)
-			{
-				g.unlock();
 				notEmptyCond_.notify_one();
-			}
+			return true;
 		}
 
 		/*
@@ -148,7 +202,7 @@ namespace vc
 				notEmptyCond_.wait(g, [=]
 								   { return !_queue.empty(); });
 			auto val = std::move(_queue.front());
-			_queue.pop();
+			_queue.pop_front();
 			if (_queue.size() == _max_size - 1)
 			{
 				g.unlock();
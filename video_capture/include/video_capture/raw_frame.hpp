@@ -2,16 +2,63 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
 
 namespace vc
 {
+template<typename T, std::size_t Alignment = 64>
+struct frame_allocator
+{
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = frame_allocator<U, Alignment>; };
+
+    frame_allocator() noexcept = default;
+
+    template<typename U>
+    frame_allocator(const frame_allocator<U, Alignment>&) noexcept { }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{ Alignment }));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t{ Alignment });
+    }
+
+    // Default-initialize instead of value-initialize: resize() does not zero-fill pixel data that is going to be overwritten anyway.
+    template<typename U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>)
+    {
+        ::new(static_cast<void*>(p)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    bool operator==(const frame_allocator<U, Alignment>&) const noexcept { return true; }
+
+    template<typename U>
+    bool operator!=(const frame_allocator<U, Alignment>&) const noexcept { return false; }
+};
+
 struct raw_frame
 {
     explicit raw_frame() = default;
     ~raw_frame() = default;
     
-    std::vector<uint8_t> data;
+    std::vector<uint8_t, frame_allocator<uint8_t>> data;
 	double pts = 0.0;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace vc
+{
+	// Fixed capacity, lock-free single producer / single consumer ring buffer.
+	// Exactly one thread may call put() and exactly one (other) thread may call get()/try_get().
+	// Blocking calls spin for a short while and only then park the thread on a condition variable,
+	// so the hot path never touches a mutex and never allocates.
+	template <typename T>
+	class spsc_queue
+	{
+	public:
+		using value_type = T;
+
+	private:
+		static constexpr size_t cache_line_size = 64;
+		static constexpr int spin_count = 256;
+		static constexpr int yield_count = 16;
+
+		struct alignas(cache_line_size) waiter
+		{
+			std::mutex lock;
+			std::condition_variable cond;
+			std::atomic_bool waiting{false};
+		};
+
+		using unique_guard = std::unique_lock<std::mutex>;
+
+		// Consumer owned line: read index and its cached copy of the write index.
+		alignas(cache_line_size) std::atomic<size_t> _head{0};
+		size_t _cached_tail{0};
+
+		// Producer owned line: write index and its cached copy of the read index.
+		alignas(cache_line_size) std::atomic<size_t> _tail{0};
+		size_t _cached_head{0};
+
+		alignas(cache_line_size) waiter _not_empty;
+		waiter _not_full;
+
+		const size_t _max_size;
+		const size_t _mask;
+		std::vector<T> _slots;
+
+		static size_t round_up_pow2(size_t n)
+		{
+			size_t p = 1;
+			while (p < n)
+				p <<= 1;
+			return p;
+		}
+
+		static void cpu_relax()
+		{
+		#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			_mm_pause();
+		#elif defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+		#elif defined(__aarch64__) || defined(__arm__)
+			asm volatile("yield");
+		#endif
+		}
+
+		template <typename Predicate>
+		static void wait(waiter &w, Predicate ready)
+		{
+			// Spinning only pays off when the other side runs on another core.
+			static const int spins = std::thread::hardware_concurrency() > 1 ? spin_count : 0;
+			for (int i = 0; i < spins; ++i)
+			{
+				if (ready())
+					return;
+				cpu_relax();
+			}
+
+			for (int i = 0; i < yield_count; ++i)
+			{
+				if (ready())
+					return;
+				std::this_thread::yield();
+			}
+
+			unique_guard g(w.lock);
+			w.waiting.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			w.cond.wait(g, ready);
+			w.waiting.store(false, std::memory_order_relaxed);
+		}
+
+		static void wake(waiter &w)
+		{
+			// Pairs with the fence in wait(): either the sleeper sees the new index, or we see it sleeping.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (w.waiting.load(std::memory_order_relaxed))
+			{
+				{
+					unique_guard g(w.lock);
+				}
+				w.cond.notify_one();
+			}
+		}
+
+	public:
+		explicit spsc_queue(size_t max_size)
+			: _max_size{std::max<size_t>(max_size, 1)}
+			, _mask{round_up_pow2(_max_size) - 1}
+			, _slots(_mask + 1)
+		{
+		}
+
+		spsc_queue(const spsc_queue &) = delete;
+		spsc_queue &operator=(const spsc_queue &) = delete;
+
+		bool is_empty() const
+		{
+			return size() == 0;
+		}
+
+		size_t get_max_size() const
+		{
+			return _max_size;
+		}
+
+		size_t size() const
+		{
+			const auto head = _head.load(std::memory_order_acquire);
+			const auto tail = _tail.load(std::memory_order_acquire);
+			return tail - head;
+		}
+
+		void put(value_type val)
+		{
+			const auto tail = _tail.load(std::memory_order_relaxed);
+			if (tail - _cached_head >= _max_size)
+			{
+				wait(_not_full, [&]
+					 { return tail - (_cached_head = _head.load(std::memory_order_acquire)) < _max_size; });
+			}
+
+			_slots[tail & _mask] = std::move(val);
+			_tail.store(tail + 1, std::memory_order_release);
+			wake(_not_empty);
+		}
+
+		bool try_put(value_type val)
+		{
+			const auto tail = _tail.load(std::memory_order_relaxed);
+			if (tail - _cached_head >= _max_size)
+			{
+				_cached_head = _head.load(std::memory_order_acquire);
+				if (tail - _cached_head >= _max_size)
+					return false;
+			}
+
+			_slots[tail & _mask] = std::move(val);
+			_tail.store(tail + 1, std::memory_order_release);
+			wake(_not_empty);
+			return true;
+		}
+
+		void get(value_type *val)
+		{
+			const auto head = _head.load(std::memory_order_relaxed);
+			if (head == _cached_tail)
+			{
+				wait(_not_empty, [&]
+					 { return head != (_cached_tail = _tail.load(std::memory_order_acquire)); });
+			}
+
+			*val = std::move(_slots[head & _mask]);
+			_head.store(head + 1, std::memory_order_release);
+			wake(_not_full);
+		}
+
+		auto get()
+		{
+			value_type val;
+			get(&val);
+			return val;
+		}
+
+		bool try_get(value_type *val)
+		{
+			const auto head = _head.load(std::memory_order_relaxed);
+			if (head == _cached_tail)
+			{
+				_cached_tail = _tail.load(std::memory_order_acquire);
+				if (head == _cached_tail)
+					return false;
+			}
+
+			*val = std::move(_slots[head & _mask]);
+			_head.store(head + 1, std::memory_order_release);
+			wake(_not_full);
+			return true;
+		}
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace vc
+{
+// Timed sections of the capture, one sample per call:
+// read is av_read_frame(), decode is avcodec_send_packet() and avcodec_receive_frame() (depending on the decoder either one does the work),
+// transfer is av_hwframe_transfer_data() and convert is the colour conversion of one frame (swscale, native kernels or plain copy).
+enum class stage { read, decode, transfer, convert };
+
+struct stage_stats
+{
+    uint64_t count = 0;
+    std::chrono::nanoseconds total{};
+    std::chrono::nanoseconds min{};
+    std::chrono::nanoseconds max{};
+    std::chrono::nanoseconds p50{};
+    std::chrono::nanoseconds p90{};
+    std::chrono::nanoseconds p99{};
+};
+
+struct stats
+{
+    // False when the library is built without statistics (VCPP_STATS=OFF): every value is zero.
+    bool is_enabled = false;
+    std::chrono::nanoseconds elapsed{};
+
+    stage_stats read;
+    stage_stats decode;
+    stage_stats transfer;
+    stage_stats convert;
+
+    uint64_t packets_read = 0;
+    uint64_t bytes_read = 0;
+    uint64_t frames_decoded = 0;
+    uint64_t decode_errors = 0;
+};
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "api.hpp"
+#include "frame_queue.hpp"
+#include "stats.hpp"
 
 #include <string>
 #include <functional>
@@ -8,6 +10,9 @@
 #include <optional>
 #include <chrono>
 #include <mutex>
+#include <array>
+#include <atomic>
+#include <map>
 
 struct AVFormatContext;
 struct AVCodecContext; 
@@ -21,8 +26,18 @@ struct AVBufferRef;
 namespace vc
 {
 struct raw_frame;
+class decoded_frame;
+struct tensor_scratch;
 enum class decode_support { none, SW, HW };
 enum class log_level { all, info, error };
+enum class log_mode { sync, async };
+enum class pixel_format { bgr24, rgb24, rgba, gray8, yuv420p, nv12 };
+enum class decode_threading { none, frame, slice, frame_and_slice };
+enum class conversion_backend { swscale, native };
+enum class scaling_algorithm { fast_bilinear, bilinear, area, bicubic };
+enum class seek_mode { fast, accurate };
+enum class tensor_layout { nhwc, nchw };
+enum class latency_profile { standard, low_latency };
 
 class API_VIDEO_CAPTURE video_capture
 {
@@ -32,30 +47,123 @@ public:
     
     using log_callback_t = std::function<void(const std::string&)>;
     void set_log_callback(const log_callback_t& cb, const log_level& level = log_level::all);    
+    void set_log_mode(log_mode mode);
+    void set_output_pixel_format(pixel_format format);
+    void set_decode_threading(decode_threading threading, int thread_count = 0);
+    void set_conversion_threads(int thread_count);
+    void set_conversion_backend(conversion_backend backend);
+    void set_output_size(int width, int height);
+    void set_scaling_algorithm(scaling_algorithm algorithm);
+    void set_crop(int x, int y, int width, int height);
+    void set_keyframes_only(bool keyframes_only);
+    void set_target_fps(double fps);
+    void set_keep_every(int n);
+    void set_normalization(const std::array<float, 3>& mean, const std::array<float, 3>& std);
+    void set_letterbox(bool letterbox, int pad_value = 114);
+    void set_latency_profile(latency_profile profile);
 
+    using options_t = std::map<std::string, std::string>;
     bool open(const std::string& video_path, decode_support decode_preference = decode_support::none);
+    bool open(const std::string& video_path, const options_t& format_options, const options_t& codec_options = {}, decode_support decode_preference = decode_support::none);
+    // Memory input: data is read in place and must stay valid until release().
+    bool open(const uint8_t* data, size_t size, decode_support decode_preference = decode_support::none);
+    bool open(const uint8_t* data, size_t size, const options_t& format_options, const options_t& codec_options = {}, decode_support decode_preference = decode_support::none);
+    bool open_mapped(const std::string& video_path, decode_support decode_preference = decode_support::none);
+    bool open_mapped(const std::string& video_path, const options_t& format_options, const options_t& codec_options = {}, decode_support decode_preference = decode_support::none);
     bool is_opened() const;
     bool read(uint8_t** data);
     bool read(raw_frame* frame);
+    bool read(decoded_frame* frame);
+    bool read(float* data);
+    size_t read_batch(size_t n, uint8_t* buffer, double* pts = nullptr, tensor_layout layout = tensor_layout::nhwc);
+    bool seek(std::chrono::steady_clock::duration timestamp, seek_mode mode = seek_mode::accurate);
+    bool seek(int64_t frame_index, seek_mode mode = seek_mode::accurate);
+    bool build_index(const std::string& index_path = {});
+    bool load_index(const std::string& index_path = {});
+    bool has_index() const;
     void release();
+
+    bool start(size_t queue_size = 4, overflow_policy policy = overflow_policy::block);
+    void stop();
+    bool is_running() const;
     
     auto get_frame_count() const -> std::optional<int>;
     auto get_duration() const -> std::optional<std::chrono::steady_clock::duration>;
     auto get_frame_size() const -> std::optional<std::tuple<int, int>>;
     auto get_frame_size_in_bytes() const -> std::optional<int>;
     auto get_fps() const -> std::optional<double>;
+    auto get_output_pixel_format() const -> pixel_format;
+    auto get_decode_threading() const -> std::optional<std::tuple<decode_threading, int>>;
+    auto get_conversion_backend() const -> conversion_backend;
+    auto get_scaling_algorithm() const -> scaling_algorithm;
+    auto get_crop() const -> std::optional<std::tuple<int, int, int, int>>;
+    auto get_letterbox_rect() const -> std::optional<std::tuple<int, int, int, int>>;
+    auto get_keyframe_index(int64_t frame_index) const -> std::optional<int64_t>;
+    bool is_keyframes_only() const;
+    auto get_latency_profile() const -> latency_profile;
+    auto get_open_time() const -> std::optional<std::chrono::steady_clock::duration>;
+    auto get_first_frame_latency() const -> std::optional<std::chrono::steady_clock::duration>;
+    auto get_dropped_frames() const -> std::optional<size_t>;
+    auto get_stats() const -> stats;
+    void reset_stats();
+    auto get_unused_format_options() const -> options_t;
+    auto get_unused_codec_options() const -> options_t;
 
 protected:
     void init();
+    void free_contexts();
     bool grab();
+    bool grab_decimated();
+    bool is_dropped(const AVFrame* frame);
     bool decode();
-    bool retrieve();
+    bool retrieve(const AVFrame* frame, uint8_t* data);
+    bool retrieve(const AVFrame* frame, uint8_t* dst_data[4], int dst_linesize[4], int dst_format);
+    bool retrieve(const AVFrame* frame, float* data);
+    double get_timestamp(const AVFrame* frame) const;
     bool is_error(const char* func_name, const int error) const;
+    bool seek_to_pts(int64_t seek_pts, int64_t min_pts, seek_mode mode);
+    void set_first_read();
+    void set_first_frame_latency();
 
 private:
+    // Demuxes and decodes its sources on separate threads, through the same internals of the decode pipeline.
+    friend class capture_group;
+
     bool _is_opened;
     std::mutex _open_mutex;
     decode_support _decode_support;
+    pixel_format _output_format;
+    std::optional<std::tuple<decode_threading, int>> _decode_threading;
+    int _conversion_threads;
+    conversion_backend _conversion_backend;
+    std::optional<std::tuple<int, int>> _output_size;
+    scaling_algorithm _scaling_algorithm;
+    std::optional<std::tuple<int, int, int, int>> _crop;
+    std::tuple<int, int, int, int> _src_rect;
+    bool _keyframes_only;
+    double _target_fps;
+    int _keep_every;
+    std::array<float, 3> _mean;
+    std::array<float, 3> _std;
+    bool _letterbox;
+    int _pad_value;
+    std::tuple<int, int, int, int> _letterbox_rect;
+    latency_profile _latency_profile;
+    std::chrono::steady_clock::duration _open_time;
+    std::atomic<std::chrono::steady_clock::rep> _first_read;
+    std::atomic<std::chrono::steady_clock::rep> _first_frame_latency;
+    std::atomic<bool> _interrupt;
+    options_t _unused_format_options;
+    options_t _unused_codec_options;
+
+    struct decimation
+    {
+        double interval = 0.0;
+        double tolerance = 0.0;
+        int keep_every = 0;
+        int64_t count = 0;
+        std::optional<double> next_pts;
+    } _decimation;
 
     AVFormatContext* _format_ctx;
     AVCodecContext* _codec_ctx; 
@@ -66,12 +174,34 @@ private:
     AVFrame* _tmp_frame;
     
     SwsContext* _sws_ctx;
+    int _scaler_format;
     AVDictionary* _options;
     int _stream_index;
     double _timestamp_unit;
+    bool _has_pending_frame;
+    std::string _video_path;
 
     class hw_acceleration;
     std::unique_ptr<hw_acceleration> _hw;
+
+    class pipeline;
+    std::unique_ptr<pipeline> _pipeline;
+
+    class slice_scaler;
+    std::unique_ptr<slice_scaler> _slice_scaler;
+
+    class packet_index;
+    std::unique_ptr<packet_index> _index;
+
+    class stats_recorder;
+    std::unique_ptr<stats_recorder> _stats;
+
+    std::unique_ptr<tensor_scratch> _tensor_scratch;
+
+    class memory_input;
+    std::unique_ptr<memory_input> _memory_input;
+
+    bool open_input(const std::string& video_path, std::unique_ptr<memory_input> input, const options_t& format_options, const options_t& codec_options, decode_support decode_preference);
 };
 
 }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <type_traits>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+namespace vc
+{
+// Free list of packets or frames, same idea of frame_pool: whoever consumes them hands them back unreferenced,
+// so that steady state demuxing and decoding allocate neither the structures nor their side data.
+template<typename T>
+class av_pool
+{
+public:
+    struct recycler
+    {
+        av_pool* pool = nullptr;
+        void operator()(T* item) const { pool->release(item); }
+    };
+
+    using handle = std::unique_ptr<T, recycler>;
+
+    explicit av_pool(size_t capacity)
+        : _capacity{ capacity }
+    {
+        _items.reserve(capacity);
+        for (size_t i = 0; i < capacity; ++i)
+            if (auto item = alloc())
+                _items.push_back(item);
+    }
+
+    ~av_pool()
+    {
+        for (auto item : _items)
+            free(item);
+    }
+
+    // Grows on demand when exhausted, the exceeding items are freed on release.
+    handle acquire()
+    {
+        T* item = nullptr;
+        {
+            std::lock_guard lock(_mutex);
+            if (!_items.empty())
+            {
+                item = _items.back();
+                _items.pop_back();
+            }
+        }
+
+        if (!item)
+            item = alloc();
+
+        return handle(item, recycler{ this });
+    }
+
+private:
+    void release(T* item)
+    {
+        unref(item);
+        {
+            std::lock_guard lock(_mutex);
+            if (_items.size() < _capacity)
+            {
+                _items.push_back(item);
+                return;
+            }
+        }
+        free(item);
+    }
+
+    static T* alloc()
+    {
+        if constexpr (std::is_same_v<T, AVPacket>)
+            return av_packet_alloc();
+        else
+            return av_frame_alloc();
+    }
+
+    static void unref(T* item)
+    {
+        if constexpr (std::is_same_v<T, AVPacket>)
+            av_packet_unref(item);
+        else
+            av_frame_unref(item);
+    }
+
+    static void free(T* item)
+    {
+        if constexpr (std::is_same_v<T, AVPacket>)
+            av_packet_free(&item);
+        else
+            av_frame_free(&item);
+    }
+
+    std::mutex _mutex;
+    std::vector<T*> _items;
+    const size_t _capacity;
+};
+
+}
@@ -0,0 +1,439 @@
+#include <video_capture/capture_group.hpp>
+#include <video_capture/raw_frame.hpp>
+#include <video_capture/frame_pool.hpp>
+
+#include "logger.hpp"
+#include "stats_recorder.hpp"
+#include "av_pool.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <utility>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace vc
+{
+namespace
+{
+    // Packets a source can demux ahead of its decoder: absorbs the bursts of live inputs while the decode task waits for a worker.
+    constexpr size_t packet_queue_size = 64;
+}
+
+struct capture_group::source
+{
+    std::string video_path;
+    size_t output = 0;
+    decode_support decode_preference = decode_support::none;
+    configure_callback_t configure;
+
+    video_capture capture;
+    std::unique_ptr<frame_pool> pool;
+    std::atomic<bool> is_opened{ false };
+    std::thread reader;
+
+    // Demuxed packets waiting for the decoder, a null packet marks the end of the stream.
+    // A scheduled source has a decode task queued or running, or it is parked: the reader does not submit another one.
+    av_pool<AVPacket> packet_pool{ packet_queue_size + 2 };
+    std::mutex packet_mutex;
+    std::condition_variable packet_cond;
+    std::deque<av_pool<AVPacket>::handle> packets;
+    bool is_scheduled = false;
+
+    // Guarded by the mutex of the output the source writes to.
+    size_t in_flight = 0;
+    bool is_parked = false;
+};
+
+struct capture_group::output
+{
+    struct item
+    {
+        int source_id;
+        frame_pool::handle frame;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<item> frames;
+    size_t active_sources = 0;
+};
+
+capture_group::capture_group(size_t thread_count, size_t output_queues, size_t queue_size) noexcept
+    : _thread_count{ thread_count > 0 ? thread_count : std::max<size_t>(std::thread::hardware_concurrency(), 1) }
+    , _queue_size{ std::max<size_t>(queue_size, 1) }
+    , _is_running{ false }
+{
+    for (size_t i = 0; i < std::max<size_t>(output_queues, 1); ++i)
+        _outputs.push_back(std::make_unique<output>());
+}
+
+capture_group::~capture_group() noexcept
+{
+    stop();
+}
+
+int capture_group::add_source(const std::string& video_path, size_t output_queue, decode_support decode_preference, const configure_callback_t& configure)
+{
+    if (_is_running)
+    {
+        log_error("Sources can not be added while the capture group is running");
+        return -1;
+    }
+
+    if (output_queue >= _outputs.size())
+    {
+        log_error("Invalid output queue", output_queue, "for source", video_path);
+        return -1;
+    }
+
+    auto s = std::make_unique<source>();
+    s->video_path = video_path;
+    s->output = output_queue;
+    s->decode_preference = decode_preference;
+    s->configure = configure;
+    _sources.push_back(std::move(s));
+    return static_cast<int>(_sources.size() - 1);
+}
+
+bool capture_group::start()
+{
+    if (_is_running)
+        return true;
+
+    if (_sources.empty())
+    {
+        log_error("Capture group has no sources");
+        return false;
+    }
+
+    for (auto& o : _outputs)
+    {
+        o->frames.clear();
+        o->active_sources = 0;
+    }
+
+    for (auto& s : _sources)
+    {
+        s->in_flight = 0;
+        s->is_parked = false;
+        s->packets.clear();
+        s->is_scheduled = false;
+        s->capture._interrupt = false;
+        ++_outputs[s->output]->active_sources;
+    }
+
+    _pool = std::make_unique<work_stealing_pool>(_thread_count);
+    _is_running = true;
+
+    // Sources are opened and demuxed by their own threads: slow network opens and reads waiting for the next packet never hold a worker.
+    for (size_t i = 0; i < _sources.size(); ++i)
+        _sources[i]->reader = std::thread(&capture_group::demux, this, static_cast<int>(i));
+
+    log_info("Capture group started:", _sources.size(), "sources,", _thread_count, "threads,", _outputs.size(), "output queues");
+    return true;
+}
+
+void capture_group::stop()
+{
+    if (!_is_running)
+        return;
+
+    _is_running = false;
+    for (auto& o : _outputs)
+    {
+        std::lock_guard lock(o->mutex);
+        o->cond.notify_all();
+    }
+
+    // Readers blocked on their input (interrupt callback) or on a full packet queue give up, they submit no more tasks once joined.
+    for (auto& s : _sources)
+    {
+        s->capture._interrupt = true;
+        {
+            std::lock_guard lock(s->packet_mutex);
+        }
+        s->packet_cond.notify_all();
+    }
+
+    for (auto& s : _sources)
+        if (s->reader.joinable())
+            s->reader.join();
+
+    // Joins the workers: every task still running completes its current packet and sees the stop flag.
+    // The pool is released only afterwards, running tasks may still submit (a no-op once shut down).
+    _pool->shutdown();
+    _pool.reset();
+
+    for (auto& o : _outputs)
+        o->frames.clear();
+
+    for (auto& s : _sources)
+        s->packets.clear();
+
+    log_info("Capture group stopped");
+}
+
+bool capture_group::is_running() const
+{
+    return _is_running;
+}
+
+// Demux thread of a source: packets are handed to the decode tasks through the packet queue, which also applies the back pressure
+// of the decoder (and through it, of the output queue).
+void capture_group::demux(int source_id)
+{
+    auto& s = *_sources[source_id];
+    auto& capture = s.capture;
+    if (!s.is_opened)
+    {
+        // Parallelism comes from the pool: decoders are single threaded unless configured otherwise.
+        capture.set_decode_threading(decode_threading::none);
+        if (s.configure)
+            s.configure(capture);
+
+        if (!capture.open(s.video_path, s.decode_preference))
+        {
+            log_error("Capture group source", source_id, "unable to open", s.video_path);
+            finish(source_id);
+            return;
+        }
+
+        s.pool = std::make_unique<frame_pool>(capture.get_frame_size_in_bytes().value(), _queue_size + 1);
+        s.is_opened = true;
+    }
+
+    const auto push = [this, &s, source_id](av_pool<AVPacket>::handle packet)
+    {
+        bool is_idle = false;
+        {
+            std::unique_lock lock(s.packet_mutex);
+            s.packet_cond.wait(lock, [this, &s] { return s.packets.size() < packet_queue_size || !_is_running; });
+            if (!_is_running)
+                return false;
+
+            s.packets.push_back(std::move(packet));
+            is_idle = !std::exchange(s.is_scheduled, true);
+        }
+
+        if (is_idle)
+            _pool->submit([this, source_id] { decode(source_id); });
+        return true;
+    };
+
+    capture.set_first_read();
+    while (_is_running)
+    {
+        auto packet = s.packet_pool.acquire();
+        if (!packet)
+        {
+            log_error("av_packet_alloc");
+            break;
+        }
+
+        if (auto r = capture._stats->measure(stage::read, [&] { return av_read_frame(capture._format_ctx, packet.get()); }); r < 0)
+        {
+            if (AVERROR(EAGAIN) == r)
+                continue;
+
+            // Interrupted reads are the stop() of the group, not an input error.
+            if (_is_running)
+                capture.is_error("av_read_frame", r);
+            break;
+        }
+
+        capture._stats->add(video_capture::stats_recorder::counter::packets_read);
+        capture._stats->add(video_capture::stats_recorder::counter::bytes_read, packet->size);
+
+        if (packet->stream_index != capture._stream_index)
+            continue;
+
+        if (capture._keyframes_only && !(packet->flags & AV_PKT_FLAG_KEY))
+            continue;
+
+        if (!push(std::move(packet)))
+            return;
+    }
+
+    push(nullptr);
+}
+
+// One decode task per source is in flight at any time: its decoder is never touched by two workers at once,
+// so it needs no locking and its frames are produced in order. Every task decodes a single packet.
+void capture_group::decode(int source_id)
+{
+    if (!_is_running)
+        return;
+
+    auto& s = *_sources[source_id];
+    auto& capture = s.capture;
+    av_pool<AVPacket>::handle packet;
+    {
+        std::lock_guard lock(s.packet_mutex);
+        if (s.packets.empty())
+        {
+            s.is_scheduled = false;
+            return;
+        }
+
+        packet = std::move(s.packets.front());
+        s.packets.pop_front();
+    }
+    s.packet_cond.notify_one();
+
+    // A null packet puts the decoder in draining mode: the remaining buffered frames are flushed out.
+    if (auto r = capture._stats->measure(stage::decode, [&] { return avcodec_send_packet(capture._codec_ctx, packet.get()); }); r < 0 && AVERROR(EAGAIN) != r)
+        if (capture.is_error("avcodec_send_packet", r))
+            capture._stats->add(video_capture::stats_recorder::counter::decode_errors);
+
+    auto& o = *_outputs[s.output];
+    while (true)
+    {
+        if (auto r = capture._stats->measure(stage::decode, [&] { return avcodec_receive_frame(capture._codec_ctx, capture._src_frame); }); r < 0)
+        {
+            if (AVERROR(EAGAIN) != r && AVERROR_EOF != r)
+            {
+                capture.is_error("avcodec_receive_frame", r);
+                capture._stats->add(video_capture::stats_recorder::counter::decode_errors);
+            }
+            break;
+        }
+
+        capture._stats->add(video_capture::stats_recorder::counter::frames_decoded);
+        capture.set_first_frame_latency();
+        if (capture.is_dropped(capture._src_frame) || !capture.decode())
+            continue;
+
+        auto frame = s.pool->acquire();
+        if (!capture.retrieve(capture._tmp_frame, frame->data.data()))
+            continue;
+
+        frame->pts = capture.get_timestamp(capture._tmp_frame);
+        {
+            std::lock_guard lock(o.mutex);
+            o.frames.push_back({ source_id, std::move(frame) });
+            ++s.in_flight;
+        }
+        o.cond.notify_one();
+    }
+
+    // End of stream: the source stays scheduled, no more tasks for it.
+    if (!packet)
+    {
+        finish(source_id);
+        return;
+    }
+
+    // Source parks itself once its share of the output queue is full, the consumer resumes it (see read()).
+    // This applies back pressure without ever blocking a worker. Parking is decided here only, after the last frame:
+    // a consumer resuming the source while this task is still running would start a second task on the same decoder.
+    bool is_parked = false;
+    {
+        std::lock_guard lock(o.mutex);
+        is_parked = s.is_parked = s.in_flight >= _queue_size;
+    }
+
+    if (!is_parked)
+        schedule(source_id);
+}
+
+// Next packet goes to a new task, at the back of the queue: sources sharing a worker take turns packet by packet.
+void capture_group::schedule(int source_id)
+{
+    auto& s = *_sources[source_id];
+    {
+        std::lock_guard lock(s.packet_mutex);
+        if (s.packets.empty())
+        {
+            s.is_scheduled = false;
+            return;
+        }
+    }
+
+    _pool->submit([this, source_id] { decode(source_id); });
+}
+
+void capture_group::finish(int source_id)
+{
+    auto& o = *_outputs[_sources[source_id]->output];
+    {
+        std::lock_guard lock(o.mutex);
+        --o.active_sources;
+    }
+    o.cond.notify_all();
+}
+
+bool capture_group::read(raw_frame* frame, int* source_id, size_t output_queue)
+{
+    if (output_queue >= _outputs.size())
+    {
+        log_error("Invalid output queue", output_queue);
+        return false;
+    }
+
+    auto& o = *_outputs[output_queue];
+    output::item item;
+    {
+        std::unique_lock lock(o.mutex);
+        o.cond.wait(lock, [this, &o] { return !o.frames.empty() || o.active_sources == 0 || !_is_running; });
+        if (o.frames.empty() || !_is_running)
+            return false;
+
+        item = std::move(o.frames.front());
+        o.frames.pop_front();
+
+        auto& s = *_sources[item.source_id];
+        --s.in_flight;
+
+        // Still under the output mutex: stop() takes it after clearing the running flag, so the pool can not be gone here.
+        if (std::exchange(s.is_parked, false))
+            _pool->submit([this, id = item.source_id] { decode(id); });
+    }
+
+    // Give the converted buffer to the caller and recycle the caller's one into the source pool.
+    std::swap(frame->data, item.frame->data);
+    frame->pts = item.frame->pts;
+    *source_id = item.source_id;
+    return true;
+}
+
+auto capture_group::get_source_count() const -> size_t
+{
+    return _sources.size();
+}
+
+auto capture_group::get_thread_count() const -> size_t
+{
+    return _thread_count;
+}
+
+auto capture_group::get_frame_size(int source_id) const -> std::optional<std::tuple<int, int>>
+{
+    if (source_id < 0 || source_id >= static_cast<int>(_sources.size()) || !_sources[source_id]->is_opened)
+    {
+        log_error("Frame size not available. Source must be opened first.");
+        return std::nullopt;
+    }
+
+    return _sources[source_id]->capture.get_frame_size();
+}
+
+auto capture_group::get_frame_size_in_bytes(int source_id) const -> std::optional<int>
+{
+    if (source_id < 0 || source_id >= static_cast<int>(_sources.size()) || !_sources[source_id]->is_opened)
+    {
+        log_error("Frame size in bytes not available. Source must be opened first.");
+        return std::nullopt;
+    }
+
+    return _sources[source_id]->capture.get_frame_size_in_bytes();
+}
+
+}
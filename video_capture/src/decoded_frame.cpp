@@ -0,0 +1,121 @@
+#include <video_capture/decoded_frame.hpp>
+
+#include <utility>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace vc
+{
+decoded_frame::decoded_frame() noexcept
+    : _frame{ nullptr }
+    , _pts{ 0.0 }
+{
+}
+
+decoded_frame::~decoded_frame() noexcept
+{
+    if(_frame)
+        av_frame_free(&_frame);
+}
+
+decoded_frame::decoded_frame(decoded_frame&& other) noexcept
+    : _frame{ std::exchange(other._frame, nullptr) }
+    , _pts{ std::exchange(other._pts, 0.0) }
+{
+}
+
+decoded_frame& decoded_frame::operator=(decoded_frame&& other) noexcept
+{
+    if(this != &other)
+    {
+        if(_frame)
+            av_frame_free(&_frame);
+
+        _frame = std::exchange(other._frame, nullptr);
+        _pts = std::exchange(other._pts, 0.0);
+    }
+
+    return *this;
+}
+
+bool decoded_frame::is_valid() const
+{
+    return _frame && _frame->buf[0];
+}
+
+void decoded_frame::release()
+{
+    // Drop the references to the decoder buffers, but keep the AVFrame shell to be reused by the next read().
+    if(_frame)
+        av_frame_unref(_frame);
+
+    _pts = 0.0;
+}
+
+auto decoded_frame::data(int plane) const -> const uint8_t*
+{
+    if(!is_valid() || plane < 0 || plane >= AV_NUM_DATA_POINTERS)
+        return nullptr;
+
+    return _frame->data[plane];
+}
+
+auto decoded_frame::linesize(int plane) const -> int
+{
+    if(!is_valid() || plane < 0 || plane >= AV_NUM_DATA_POINTERS)
+        return 0;
+
+    return _frame->linesize[plane];
+}
+
+auto decoded_frame::get_planes() const -> int
+{
+    if(!is_valid())
+        return 0;
+
+    return av_pix_fmt_count_planes((AVPixelFormat)_frame->format);
+}
+
+auto decoded_frame::get_width() const -> int
+{
+    return is_valid() ? _frame->width : 0;
+}
+
+auto decoded_frame::get_height() const -> int
+{
+    return is_valid() ? _frame->height : 0;
+}
+
+auto decoded_frame::get_pts() const -> double
+{
+    return _pts;
+}
+
+auto decoded_frame::get_format() const -> std::optional<pixel_format>
+{
+    if(!is_valid())
+        return std::nullopt;
+
+    switch (_frame->format)
+    {
+        case AV_PIX_FMT_BGR24:      return pixel_format::bgr24;
+        case AV_PIX_FMT_RGB24:      return pixel_format::rgb24;
+        case AV_PIX_FMT_RGBA:       return pixel_format::rgba;
+        case AV_PIX_FMT_GRAY8:      return pixel_format::gray8;
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P:   return pixel_format::yuv420p;
+        case AV_PIX_FMT_NV12:       return pixel_format::nv12;
+        default:                    return std::nullopt;
+    }
+}
+
+auto decoded_frame::get_native_format() const -> int
+{
+    return is_valid() ? _frame->format : AV_PIX_FMT_NONE;
+}
+
+}
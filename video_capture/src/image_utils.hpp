@@ -0,0 +1,72 @@
+#pragma once
+
+#include "yuv_to_rgb.hpp"
+
+#include <algorithm>
+
+extern "C"
+{
+#include <libavutil/pixdesc.h>
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace vc
+{
+// Offset the planes of an image to the pixel (x, y), taking chroma subsampling and pixel step of each plane into account.
+// Coordinates must be multiple of the chroma subsampling factors of the pixel format.
+inline void offset_planes(AVPixelFormat format, uint8_t* const data[4], const int linesize[4], int x, int y, uint8_t* out[4])
+{
+    const auto desc = av_pix_fmt_desc_get(format);
+    for (int plane = 0; plane < 4; ++plane)
+    {
+        out[plane] = data[plane];
+        if (!desc || !data[plane])
+            continue;
+
+        int step = 0;
+        bool is_chroma = false;
+        for (int c = 0; c < desc->nb_components; ++c)
+        {
+            if (desc->comp[c].plane != plane)
+                continue;
+
+            step = desc->comp[c].step;
+            is_chroma = !(desc->flags & AV_PIX_FMT_FLAG_RGB) && (c == 1 || c == 2);
+        }
+
+        const int plane_x = is_chroma ? (x >> desc->log2_chroma_w) : x;
+        const int plane_y = is_chroma ? (y >> desc->log2_chroma_h) : y;
+        out[plane] = data[plane] + plane_y * linesize[plane] + plane_x * step;
+    }
+}
+
+inline int get_chroma_alignment(AVPixelFormat format)
+{
+    const auto desc = av_pix_fmt_desc_get(format);
+    return desc ? (1 << std::max(desc->log2_chroma_w, desc->log2_chroma_h)) : 1;
+}
+
+// Untagged streams are assumed BT.601, as swscale does by default.
+inline yuv_matrix get_yuv_matrix(const AVFrame* frame)
+{
+    return frame->colorspace == AVCOL_SPC_BT709 ? yuv_matrix::bt709 : yuv_matrix::bt601;
+}
+
+inline bool is_full_range(const AVFrame* frame)
+{
+    return frame->color_range == AVCOL_RANGE_JPEG || frame->format == AV_PIX_FMT_YUVJ420P;
+}
+
+// Make swscale honour the matrix and range the frame is tagged with, so that every conversion backend yields the same colours.
+// RGB outputs are full range. YUV and gray outputs keep the range and matrix of the source: swscale would convert them otherwise.
+inline void set_colorspace_details(SwsContext* sws_ctx, const AVFrame* frame, AVPixelFormat dst_format)
+{
+    const auto desc = av_pix_fmt_desc_get(dst_format);
+    const bool is_rgb = desc && (desc->flags & AV_PIX_FMT_FLAG_RGB);
+    const int src_range = is_full_range(frame) ? 1 : 0;
+    const auto coefficients = sws_getCoefficients(get_yuv_matrix(frame) == yuv_matrix::bt709 ? SWS_CS_ITU709 : SWS_CS_ITU601);
+    sws_setColorspaceDetails(sws_ctx, coefficients, src_range, coefficients, is_rgb ? 1 : src_range, 0, 1 << 16, 1 << 16);
+}
+
+}
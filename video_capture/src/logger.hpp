@@ -1,23 +1,47 @@
 #pragma once
 
-#include <sstream>
 #include <utility>
 #include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <charconv>
+#include <cstdio>
 #include <cstring>
-#include <map>
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
 
 extern "C"
 {
 #include <libavutil/error.h>
 }
 
+// Lowest level compiled in: calls below it expand to nothing, their arguments are not even evaluated.
+#define VIDEO_CAPTURE_LOG_LEVEL_INFO 0
+#define VIDEO_CAPTURE_LOG_LEVEL_ERROR 1
+#if !defined(VIDEO_CAPTURE_LOG_LEVEL)
+    #define VIDEO_CAPTURE_LOG_LEVEL VIDEO_CAPTURE_LOG_LEVEL_INFO
+#endif
+
 #if defined(VIDEO_CAPTURE_LOG_ENABLED)
-    #include <mutex>
     #include <iostream>
+#endif
+
+#if defined(VIDEO_CAPTURE_LOG_ENABLED) && VIDEO_CAPTURE_LOG_LEVEL <= VIDEO_CAPTURE_LOG_LEVEL_INFO
     #define log_info(...) vc::logger::get().log(log_level::info, ##__VA_ARGS__)
-    #define log_error(...) vc::logger::get().log(log_level::error, ##__VA_ARGS__)
 #else
     #define log_info(...) (void)0
+#endif
+
+#if defined(VIDEO_CAPTURE_LOG_ENABLED) && VIDEO_CAPTURE_LOG_LEVEL <= VIDEO_CAPTURE_LOG_LEVEL_ERROR
+    #define log_error(...) vc::logger::get().log(log_level::error, ##__VA_ARGS__)
+#else
     #define log_error(...) (void)0
 #endif
 
@@ -26,6 +50,18 @@ namespace vc
 class logger
 {
 public:
+    static constexpr size_t max_message_size = 480;
+    static constexpr size_t async_queue_size = 256;
+    static constexpr uint32_t max_repeats = 5;
+
+    using log_callback_t = std::function<void(const std::string&)>;
+
+    // Returned by value: every caller gets its own buffer.
+    struct error_string
+    {
+        char str[AV_ERROR_MAX_STRING_SIZE] = {};
+    };
+
     logger()
     {
     #if defined(VIDEO_CAPTURE_LOG_ENABLED)
@@ -34,41 +70,385 @@ public:
     #endif
     }
 
+    ~logger()
+    {
+        set_async(false);
+    }
+
     static logger& get()
     {
         static logger instance;
         return instance;
     }
 
+    // Formatting happens on the caller stack (no allocation, no stream), the callback runs on the caller thread or,
+    // in async mode, on the logger thread: the caller only pays for a copy into a lock free ring buffer.
     template<typename... Args>
-    void log(const log_level& level, Args&& ...args)
+    void log(log_level level, Args&& ...args)
     {
-        if(auto cb = log_callbacks.find(level); cb != log_callbacks.end())
+        if (!_has_callback[get_index(level)].load(std::memory_order_relaxed))
+            return;
+
+        message m;
+        m.level = level;
+        (m.append(std::forward<Args>(args)), ...);
+
+        flush_suppressed(true);
+        if (level == log_level::error && is_rate_limited(m))
+            return;
+
+        emit(m);
+    }
+
+    void set_log_callback(const log_callback_t& cb, const log_level& level)
+    {
+        std::lock_guard lock(_callback_mutex);
+        for (auto l : { log_level::info, log_level::error })
         {
-            std::stringstream s;
-            ((s << std::forward<Args>(args) << ' ') , ...);
-            cb->second(s.str());
+            if (level != log_level::all && level != l)
+                continue;
+
+            _callbacks[get_index(l)] = cb ? std::make_shared<const log_callback_t>(cb) : nullptr;
+            _has_callback[get_index(l)].store(static_cast<bool>(cb), std::memory_order_relaxed);
         }
     }
 
-    using log_callback_t = std::function<void(const std::string&)>;
-    void set_log_callback(const log_callback_t& cb, const log_level& level)
+    // Synchronous by default. Switching back to synchronous flushes the pending messages first.
+    // Ignored when called by a callback in async mode: the logger thread can not join itself.
+    void set_async(bool is_async)
+    {
+        if (std::this_thread::get_id() == _thread_id)
+            return;
+
+        std::lock_guard lock(_async_mutex);
+        if (is_async == _is_async.load())
+            return;
+
+        if (is_async)
+        {
+            if (!_queue)
+                _queue = std::make_unique<ring_buffer>();
+
+            _stop = false;
+            _is_async = true;
+            _thread = std::thread(&logger::async_loop, this);
+            _thread_id = _thread.get_id();
+            return;
+        }
+
+        _is_async = false;
+        {
+            std::lock_guard wake_lock(_wake_mutex);
+            _stop = true;
+        }
+        _wake_cond.notify_one();
+        _thread.join();
+        _thread_id = std::thread::id{};
+
+        // Producers that saw async mode just before the switch may have pushed after the logger thread drained the ring.
+        message m;
+        while (_queue->try_pop(m))
+            dispatch(m);
+    }
+
+    // Reports the errors still held back by the rate limiter, also the ones whose second is not over yet.
+    void flush_suppressed()
+    {
+        flush_suppressed(false);
+    }
+
+    error_string err2str(int errnum) const
+    {
+        error_string e;
+        av_make_error_string(e.str, AV_ERROR_MAX_STRING_SIZE, errnum);
+        return e;
+    }
+
+private:
+    struct message
+    {
+        log_level level = log_level::info;
+        uint32_t size = 0;
+        char text[max_message_size];
+
+        void write(std::string_view s)
+        {
+            const auto n = std::min(s.size(), max_message_size - size);
+            std::memcpy(text + size, s.data(), n);
+            size += static_cast<uint32_t>(n);
+        }
+
+        // Same output of the former stream based formatting: every argument followed by a space.
+        template<typename T>
+        void append(const T& value)
+        {
+            using type = std::decay_t<T>;
+            if constexpr (std::is_same_v<type, error_string>)
+            {
+                write(value.str);
+            }
+            else if constexpr (std::is_same_v<type, bool>)
+            {
+                write(value ? "1" : "0");
+            }
+            else if constexpr (std::is_same_v<type, char>)
+            {
+                write(std::string_view(&value, 1));
+            }
+            else if constexpr (std::is_integral_v<type> || std::is_enum_v<type>)
+            {
+                char buffer[24];
+                const auto r = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<std::conditional_t<std::is_enum_v<type>, int64_t, type>>(value));
+                write(std::string_view(buffer, r.ptr - buffer));
+            }
+            else if constexpr (std::is_floating_point_v<type>)
+            {
+                char buffer[32];
+                const auto n = std::snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+                write(std::string_view(buffer, std::clamp(n, 0, static_cast<int>(sizeof(buffer)) - 1)));
+            }
+            else if constexpr (std::is_convertible_v<type, const char*>)
+            {
+                if (const char* str = value)
+                    write(str);
+            }
+            else
+            {
+                write(std::string_view(value));
+            }
+            write(" ");
+        }
+    };
+
+    // Bounded multi producer / single consumer queue (sequence numbered slots): producers never wait, a full queue drops the message.
+    class ring_buffer
+    {
+    public:
+        ring_buffer()
+        {
+            for (size_t i = 0; i < async_queue_size; ++i)
+                _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        bool try_push(const message& m)
+        {
+            auto pos = _tail.load(std::memory_order_relaxed);
+            while (true)
+            {
+                auto& slot = _slots[pos % async_queue_size];
+                const auto sequence = slot.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0)
+                {
+                    if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        copy(slot.m, m);
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = _tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(message& m)
+        {
+            auto& slot = _slots[_head % async_queue_size];
+            if (slot.sequence.load(std::memory_order_acquire) != _head + 1)
+                return false;
+
+            copy(m, slot.m);
+            slot.sequence.store(_head + async_queue_size, std::memory_order_release);
+            ++_head;
+            return true;
+        }
+
+    private:
+        // Only the formatted part of the message is copied.
+        static void copy(message& dst, const message& src)
+        {
+            dst.level = src.level;
+            dst.size = src.size;
+            std::memcpy(dst.text, src.text, src.size);
+        }
+
+        struct slot
+        {
+            std::atomic<size_t> sequence;
+            message m;
+        };
+
+        std::array<slot, async_queue_size> _slots;
+        alignas(64) std::atomic<size_t> _tail{ 0 };
+        alignas(64) size_t _head = 0;
+    };
+
+    // Errors only: up to max_repeats identical messages per second, the following ones are counted and reported once their second is over,
+    // by the next message logged, by the logger thread in async mode or by flush_suppressed(). Slots are shared by hash:
+    // a colliding message reports the count of the previous one before taking over its slot.
+    struct rate_slot
     {
-        if(level == log_level::all)
+        std::mutex mutex;
+        uint64_t hash = 0;
+        int64_t second = 0;
+        uint32_t count = 0;
+        uint32_t suppressed = 0;
+        message suppressed_message;
+    };
+
+    static int64_t get_second()
+    {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool is_rate_limited(const message& m)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t i = 0; i < m.size; ++i)
+            hash = (hash ^ static_cast<uint8_t>(m.text[i])) * 1099511628211ull;
+
+        const auto second = get_second();
+        auto& slot = _rate_slots[hash % _rate_slots.size()];
+        message report;
         {
-            log_callbacks[log_level::info] = cb;
-            log_callbacks[log_level::error] = cb;
+            std::lock_guard lock(slot.mutex);
+            if (slot.hash == hash && slot.second == second)
+            {
+                if (++slot.count <= max_repeats)
+                    return false;
+
+                if (slot.suppressed++ == 0)
+                {
+                    slot.suppressed_message = m;
+                    _suppressed_slots.fetch_add(1, std::memory_order_relaxed);
+                }
+                return true;
+            }
+
+            take_report(slot, report);
+            slot.hash = hash;
+            slot.second = second;
+            slot.count = 1;
+        }
+
+        // Outside of the slot lock: the callback may log itself.
+        if (report.size > 0)
+            emit(report);
+        return false;
+    }
+
+    // Slot must be locked. Leaves the report empty when nothing was suppressed.
+    void take_report(rate_slot& slot, message& report)
+    {
+        if (slot.suppressed == 0)
             return;
+
+        report = slot.suppressed_message;
+        report.write("(");
+        report.append(slot.suppressed);
+        report.write("identical messages suppressed)");
+        slot.suppressed = 0;
+        _suppressed_slots.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Only walks the slots when some error is actually held back.
+    void flush_suppressed(bool is_expired_only)
+    {
+        if (_suppressed_slots.load(std::memory_order_relaxed) == 0)
+            return;
+
+        const auto second = get_second();
+        for (auto& slot : _rate_slots)
+        {
+            message report;
+            {
+                std::lock_guard lock(slot.mutex);
+                if (is_expired_only && slot.second == second)
+                    continue;
+
+                take_report(slot, report);
+            }
+
+            if (report.size > 0)
+                emit(report);
+        }
+    }
+
+    void emit(const message& m)
+    {
+        if (_is_async.load(std::memory_order_acquire))
+        {
+            if (!_queue->try_push(m))
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+            else if (_is_sleeping.load(std::memory_order_acquire))
+                _wake_cond.notify_one();
+            return;
+        }
+
+        dispatch(m);
+    }
+
+    // Callback runs unlocked: it may log or change the callbacks itself.
+    void dispatch(const message& m)
+    {
+        std::shared_ptr<const log_callback_t> cb;
+        {
+            std::lock_guard lock(_callback_mutex);
+            cb = _callbacks[get_index(m.level)];
         }
 
-        log_callbacks[level] = cb;
+        if (cb)
+            (*cb)(std::string(m.text, m.size));
     }
 
-    const char* err2str(int errnum)
+    void async_loop()
     {
-        static char str[AV_ERROR_MAX_STRING_SIZE];
-        std::memset(str, 0, sizeof(str));
-        return av_make_error_string(str, AV_ERROR_MAX_STRING_SIZE, errnum);
+        message m;
+        while (true)
+        {
+            if (const auto dropped = _dropped.exchange(0, std::memory_order_relaxed); dropped > 0)
+            {
+                message d;
+                d.level = log_level::error;
+                d.append("Log queue full:");
+                d.append(dropped);
+                d.append("messages dropped");
+                dispatch(d);
+            }
+
+            // Errors held back are reported once their second is over, even if no other message comes.
+            flush_suppressed(true);
+
+            if (_queue->try_pop(m))
+            {
+                dispatch(m);
+                continue;
+            }
+
+            // Idle: producers only notify when the logger thread is actually waiting, the timeout covers the lost wake ups.
+            std::unique_lock lock(_wake_mutex);
+            if (_stop)
+                break;
+
+            _is_sleeping.store(true, std::memory_order_release);
+            _wake_cond.wait_for(lock, std::chrono::milliseconds(10));
+            _is_sleeping.store(false, std::memory_order_release);
+        }
+
+        while (_queue->try_pop(m))
+            dispatch(m);
+    }
+
+    static size_t get_index(log_level level)
+    {
+        return level == log_level::error ? 1 : 0;
     }
 
 #if defined(VIDEO_CAPTURE_LOG_ENABLED)
@@ -89,7 +469,23 @@ protected:
 #endif
 
 private:
-    std::map<log_level, log_callback_t> log_callbacks;
+    std::array<std::shared_ptr<const log_callback_t>, 2> _callbacks;
+    std::array<std::atomic<bool>, 2> _has_callback{};
+    std::mutex _callback_mutex;
+
+    std::array<rate_slot, 64> _rate_slots;
+    std::atomic<size_t> _suppressed_slots{ 0 };
+
+    std::mutex _async_mutex;
+    std::atomic<bool> _is_async{ false };
+    std::unique_ptr<ring_buffer> _queue;
+    std::atomic<uint64_t> _dropped{ 0 };
+    std::thread _thread;
+    std::atomic<std::thread::id> _thread_id{};
+    std::mutex _wake_mutex;
+    std::condition_variable _wake_cond;
+    std::atomic<bool> _is_sleeping{ false };
+    bool _stop = false;
 };
 
 }
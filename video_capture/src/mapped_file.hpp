@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace vc
+{
+// Read only memory mapping of a whole file.
+class mapped_file
+{
+public:
+    explicit mapped_file() = default;
+    ~mapped_file() { close(); }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    bool open(const std::string& path)
+    {
+        close();
+
+#if defined(_WIN32)
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+
+        if (_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr); !_mapping)
+        {
+            close();
+            return false;
+        }
+
+        if (_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)); !_data)
+        {
+            close();
+            return false;
+        }
+        _size = static_cast<size_t>(size.QuadPart);
+#else
+        if (_fd = ::open(path.c_str(), O_RDONLY); _fd < 0)
+            return false;
+
+        struct stat st = {};
+        if (fstat(_fd, &st) != 0 || st.st_size == 0)
+        {
+            close();
+            return false;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+        _data = static_cast<const uint8_t*>(data);
+        _size = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#if defined(_WIN32)
+        if (_data)
+            UnmapViewOfFile(_data);
+        if (_mapping)
+            CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE)
+            CloseHandle(_file);
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data)
+            munmap(const_cast<uint8_t*>(_data), _size);
+        if (_fd >= 0)
+            ::close(_fd);
+        _fd = -1;
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    bool is_open() const { return _data != nullptr; }
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+
+#if defined(_WIN32)
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _fd = -1;
+#endif
+};
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "logger.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavutil/mem.h>
+}
+
+namespace vc
+{
+// Demuxer input served straight from memory through a custom AVIOContext: either a span owned by the caller
+// or a memory mapped file. The AVIO buffer is the only copy, as for a plain file read.
+class video_capture::memory_input
+{
+public:
+    static constexpr int buffer_size = 64 * 1024;
+
+    explicit memory_input() = default;
+    ~memory_input() { close(); }
+
+    memory_input(const memory_input&) = delete;
+    memory_input& operator=(const memory_input&) = delete;
+
+    bool open(const uint8_t* data, size_t size)
+    {
+        close();
+
+        if (!data || size == 0)
+        {
+            log_error("Invalid memory input: empty buffer");
+            return false;
+        }
+
+        _data = data;
+        _size = static_cast<int64_t>(size);
+        return init();
+    }
+
+    bool open(const std::string& video_path)
+    {
+        close();
+
+        if (!_file.open(video_path))
+        {
+            log_error("Unable to map file", video_path);
+            return false;
+        }
+
+        _data = _file.data();
+        _size = static_cast<int64_t>(_file.size());
+        return init();
+    }
+
+    void close()
+    {
+        // The format context does not own a custom AVIOContext (nor its buffer, possibly reallocated by FFmpeg).
+        if (_avio_ctx)
+        {
+            av_freep(&_avio_ctx->buffer);
+            avio_context_free(&_avio_ctx);
+        }
+
+        _file.close();
+        _data = nullptr;
+        _size = 0;
+        _position = 0;
+    }
+
+    AVIOContext* get_context() const { return _avio_ctx; }
+    bool is_mapped() const { return _file.is_open(); }
+
+private:
+    bool init()
+    {
+        auto buffer = static_cast<unsigned char*>(av_malloc(buffer_size));
+        if (!buffer)
+        {
+            log_error("av_malloc");
+            close();
+            return false;
+        }
+
+        if (_avio_ctx = avio_alloc_context(buffer, buffer_size, 0, this, &memory_input::read, nullptr, &memory_input::seek); !_avio_ctx)
+        {
+            log_error("avio_alloc_context");
+            av_free(buffer);
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    static int read(void* opaque, uint8_t* buf, int buf_size)
+    {
+        auto self = static_cast<memory_input*>(opaque);
+        const auto n = std::min<int64_t>(buf_size, self->_size - self->_position);
+        if (n <= 0)
+            return AVERROR_EOF;
+
+        std::memcpy(buf, self->_data + self->_position, static_cast<size_t>(n));
+        self->_position += n;
+        return static_cast<int>(n);
+    }
+
+    static int64_t seek(void* opaque, int64_t offset, int whence)
+    {
+        auto self = static_cast<memory_input*>(opaque);
+        int64_t position = 0;
+        switch (whence & ~AVSEEK_FORCE)
+        {
+            case AVSEEK_SIZE:   return self->_size;
+            case SEEK_SET:      position = offset; break;
+            case SEEK_CUR:      position = self->_position + offset; break;
+            case SEEK_END:      position = self->_size + offset; break;
+            default:            return AVERROR(EINVAL);
+        }
+
+        if (position < 0 || position > self->_size)
+            return AVERROR(EINVAL);
+
+        self->_position = position;
+        return position;
+    }
+
+    mapped_file _file;
+    const uint8_t* _data = nullptr;
+    int64_t _size = 0;
+    int64_t _position = 0;
+    AVIOContext* _avio_ctx = nullptr;
+};
+
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "logger.hpp"
+#include "mapped_file.hpp"
+
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <optional>
+#include <cstring>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+namespace vc
+{
+class video_capture::packet_index
+{
+public:
+    // Sidecar file layout (native endianness): header, one entry per packet in presentation order, ordinals of the keyframe entries.
+    // Entries are plain data, so a loaded index is the memory mapped file itself: no parsing, no allocation.
+    struct header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t entry_size;
+        int64_t file_size;
+        int32_t stream_index;
+        int32_t time_base_num;
+        int32_t time_base_den;
+        uint32_t reserved;
+        uint64_t fingerprint;
+        uint64_t entry_count;
+        uint64_t keyframe_count;
+    };
+
+    struct entry
+    {
+        int64_t pts;
+        int64_t dts;
+        int64_t pos;
+        int32_t size;
+        int32_t flags;
+    };
+
+    static_assert(sizeof(header) == 64 && sizeof(entry) == 32, "Packet index layout must not depend on the compiler");
+
+    static constexpr char magic[8] = { 'V', 'C', 'I', 'D', 'X', 0, 0, 0 };
+    static constexpr uint32_t version = 2;
+    static constexpr int fingerprint_size = 64 * 1024;
+
+    static std::string get_default_path(const std::string& video_path) { return video_path + ".vcidx"; }
+
+    // Content fingerprint: hash of the first and last 64 KiB of the input, so that another file of the same size is not mistaken
+    // for the indexed one (a re-encode, a copy with the same name). Read position is restored, the demuxer does not notice.
+    static uint64_t get_fingerprint(AVIOContext* pb)
+    {
+        if (!pb || !(pb->seekable & AVIO_SEEKABLE_NORMAL))
+            return 0;
+
+        const auto size = avio_size(pb);
+        const auto position = avio_tell(pb);
+        uint64_t hash = 14695981039346656037ull;
+        std::vector<uint8_t> buffer(fingerprint_size);
+        for (const int64_t offset : { int64_t{ 0 }, std::max<int64_t>(size - fingerprint_size, 0) })
+        {
+            if (avio_seek(pb, offset, SEEK_SET) < 0)
+                break;
+
+            const auto n = avio_read(pb, buffer.data(), fingerprint_size);
+            for (int i = 0; i < n; ++i)
+                hash = (hash ^ buffer[i]) * 1099511628211ull;
+        }
+
+        avio_seek(pb, position, SEEK_SET);
+        return hash;
+    }
+
+    // Demux only pass (no decoding) over the probed context of the capture: stream indices, time bases and start times are the very
+    // same the capture reads with (a fresh context could number the streams of e.g. MPEG-TS differently). The context is left at the
+    // end of the input, the caller seeks back.
+    static bool build(AVFormatContext* format_ctx, int stream_index, const std::string& index_path)
+    {
+        if (stream_index < 0 || stream_index >= static_cast<int>(format_ctx->nb_streams))
+        {
+            log_error("Unable to build packet index: invalid stream index", stream_index);
+            return false;
+        }
+
+        const auto stream = format_ctx->streams[stream_index];
+        const auto start_time = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        if (auto r = av_seek_frame(format_ctx, stream_index, start_time, AVSEEK_FLAG_BACKWARD); r < 0)
+        {
+            log_error("av_seek_frame", vc::logger::get().err2str(r));
+            return false;
+        }
+
+        // Other streams are skipped by the demuxer while indexing, their setting is restored afterwards.
+        std::vector<AVDiscard> discard(format_ctx->nb_streams);
+        for (unsigned int i = 0; i < format_ctx->nb_streams; ++i)
+        {
+            discard[i] = format_ctx->streams[i]->discard;
+            if (static_cast<int>(i) != stream_index)
+                format_ctx->streams[i]->discard = AVDISCARD_ALL;
+        }
+
+        header h = {};
+        std::memcpy(h.magic, magic, sizeof(magic));
+        h.version = version;
+        h.entry_size = sizeof(entry);
+        h.file_size = format_ctx->pb ? avio_size(format_ctx->pb) : -1;
+        h.stream_index = stream_index;
+        h.time_base_num = stream->time_base.num;
+        h.time_base_den = stream->time_base.den;
+        h.fingerprint = get_fingerprint(format_ctx->pb);
+
+        std::vector<entry> entries;
+        AVPacket* packet = av_packet_alloc();
+        while (packet)
+        {
+            if (auto r = av_read_frame(format_ctx, packet); r < 0)
+            {
+                if (AVERROR(EAGAIN) == r)
+                    continue;
+
+                if (AVERROR_EOF != r)
+                    log_error("av_read_frame", vc::logger::get().err2str(r));
+                break;
+            }
+
+            if (packet->stream_index == stream_index)
+            {
+                entry e = {};
+                e.pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+                e.dts = packet->dts;
+                e.pos = packet->pos;
+                e.size = packet->size;
+                e.flags = packet->flags;
+                entries.push_back(e);
+            }
+            av_packet_unref(packet);
+        }
+        av_packet_free(&packet);
+
+        for (unsigned int i = 0; i < format_ctx->nb_streams; ++i)
+            format_ctx->streams[i]->discard = discard[i];
+
+        // Presentation order: the n-th entry is the n-th frame returned by read().
+        std::stable_sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) { return a.pts < b.pts; });
+
+        std::vector<uint64_t> keyframes;
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (entries[i].flags & AV_PKT_FLAG_KEY)
+                keyframes.push_back(i);
+
+        h.entry_count = entries.size();
+        h.keyframe_count = keyframes.size();
+
+        std::ofstream file(index_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(entry));
+        file.write(reinterpret_cast<const char*>(keyframes.data()), keyframes.size() * sizeof(uint64_t));
+        if (!file)
+        {
+            log_error("Unable to write packet index", index_path);
+            return false;
+        }
+
+        log_info("Packet index built:", index_path, entries.size(), "packets", keyframes.size(), "keyframes");
+        return true;
+    }
+
+    // Index is rejected if it does not belong to the opened file (different size, stream, time base or content), e.g. a stale sidecar,
+    // or if it is corrupted: counts are bounded by the file size before being multiplied, keyframes must point at entries.
+    bool load(const std::string& index_path, AVFormatContext* format_ctx, int stream_index)
+    {
+        if (!_file.open(index_path))
+            return false;
+
+        const auto h = reinterpret_cast<const header*>(_file.data());
+        const auto time_base = format_ctx->streams[stream_index]->time_base;
+        bool is_valid = _file.size() >= sizeof(header)
+            && std::memcmp(h->magic, magic, sizeof(magic)) == 0
+            && h->version == version
+            && h->entry_size == sizeof(entry)
+            && h->file_size == (format_ctx->pb ? avio_size(format_ctx->pb) : -1)
+            && h->stream_index == stream_index
+            && h->time_base_num == time_base.num
+            && h->time_base_den == time_base.den
+            && h->entry_count <= _file.size() / sizeof(entry)
+            && h->keyframe_count <= _file.size() / sizeof(uint64_t)
+            && _file.size() == sizeof(header) + h->entry_count * sizeof(entry) + h->keyframe_count * sizeof(uint64_t);
+
+        if (is_valid)
+        {
+            const auto keyframes = reinterpret_cast<const uint64_t*>(_file.data() + sizeof(header) + h->entry_count * sizeof(entry));
+            is_valid = std::all_of(keyframes, keyframes + h->keyframe_count, [h](uint64_t k) { return k < h->entry_count; })
+                && h->fingerprint == get_fingerprint(format_ctx->pb);
+        }
+
+        if (!is_valid)
+        {
+            log_info("Packet index ignored, it does not match the opened file:", index_path);
+            _file.close();
+            return false;
+        }
+
+        _header = h;
+        _entries = reinterpret_cast<const entry*>(_file.data() + sizeof(header));
+        _keyframes = reinterpret_cast<const uint64_t*>(_file.data() + sizeof(header) + h->entry_count * sizeof(entry));
+        return true;
+    }
+
+    size_t size() const { return _header ? static_cast<size_t>(_header->entry_count) : 0; }
+    const entry& operator[](size_t frame_index) const { return _entries[frame_index]; }
+
+    // First frame presented at or after the given timestamp.
+    std::optional<size_t> find_frame(int64_t pts) const
+    {
+        const auto end = _entries + size();
+        const auto it = std::lower_bound(_entries, end, pts, [](const entry& e, int64_t value) { return e.pts < value; });
+        return it != end ? std::make_optional(static_cast<size_t>(it - _entries)) : std::nullopt;
+    }
+
+    // Keyframe that opens the group of pictures containing the frame.
+    std::optional<size_t> find_keyframe(size_t frame_index) const
+    {
+        if (!_header)
+            return std::nullopt;
+
+        const auto end = _keyframes + _header->keyframe_count;
+        const auto it = std::upper_bound(_keyframes, end, static_cast<uint64_t>(frame_index));
+        return it != _keyframes ? std::make_optional(static_cast<size_t>(*(it - 1))) : std::nullopt;
+    }
+
+private:
+    mapped_file _file;
+    const header* _header = nullptr;
+    const entry* _entries = nullptr;
+    const uint64_t* _keyframes = nullptr;
+};
+
+}
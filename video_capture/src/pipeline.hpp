@@ -0,0 +1,246 @@
+#pragma once
+
+#include "logger.hpp"
+#include "stats_recorder.hpp"
+#include "av_pool.hpp"
+
+#include <video_capture/raw_frame.hpp>
+#include <video_capture/frame_pool.hpp>
+#include <video_capture/frame_queue.hpp>
+#include <video_capture/spsc_queue.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+
+namespace vc
+{
+class video_capture::pipeline
+{
+    using packet_ptr = av_pool<AVPacket>::handle;
+    using frame_ptr = av_pool<AVFrame>::handle;
+
+public:
+    explicit pipeline(video_capture& vc, size_t queue_size, size_t frame_size, overflow_policy policy)
+        : _vc{ vc }
+        , _stop{ false }
+        , _eos{ false }
+        , _packet_pool{ queue_size + 2 }
+        , _frame_pool{ queue_size + 2 }
+        , _packets{ queue_size }
+        , _frames{ queue_size }
+        , _output{ queue_size, policy }
+        , _pool{ frame_size, queue_size + 2 }
+    {
+    }
+
+    ~pipeline()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        // Each stage runs on its own thread and talks to the next one through a bounded queue.
+        // An empty packet/frame is the end of stream marker and it is always forwarded downstream.
+        _demux_thread = std::thread(&pipeline::demux_stage, this);
+        _decode_thread = std::thread(&pipeline::decode_stage, this);
+        _convert_thread = std::thread(&pipeline::convert_stage, this);
+    }
+
+    void stop()
+    {
+        _stop = true;
+
+        // The consumer might have stopped reading: drain the output queue until the end of stream marker,
+        // so that every stage can get unblocked and exit.
+        if (!_eos)
+        {
+            frame_pool::handle frame;
+            do { _output.get(&frame); } while (frame);
+            _eos = true;
+        }
+
+        for (auto t : { &_demux_thread, &_decode_thread, &_convert_thread })
+            if (t->joinable())
+                t->join();
+    }
+
+    size_t get_dropped_count() const
+    {
+        return _output.get_dropped_count();
+    }
+
+    bool read(raw_frame* frame)
+    {
+        if (_eos)
+            return false;
+
+        frame_pool::handle output;
+        _output.get(&output);
+        if (!output)
+        {
+            _eos = true;
+            return false;
+        }
+
+        // Give the converted buffer to the caller and recycle the caller's one into the pool.
+        std::swap(frame->data, output->data);
+        frame->pts = output->pts;
+        return true;
+    }
+
+private:
+    void demux_stage()
+    {
+        _vc.set_first_read();
+        while (!_stop)
+        {
+            auto packet = _packet_pool.acquire();
+            if (!packet)
+            {
+                log_error("av_packet_alloc");
+                break;
+            }
+
+            if (auto r = _vc._stats->measure(stage::read, [&] { return av_read_frame(_vc._format_ctx, packet.get()); }); r < 0)
+            {
+                if (AVERROR(EAGAIN) == r)
+                    continue;
+
+                _vc.is_error("av_read_frame", r);
+                break;
+            }
+
+            _vc._stats->add(stats_recorder::counter::packets_read);
+            _vc._stats->add(stats_recorder::counter::bytes_read, packet->size);
+
+            if (packet->stream_index != _vc._stream_index)
+                continue;
+
+            if (_vc._keyframes_only && !(packet->flags & AV_PKT_FLAG_KEY))
+                continue;
+
+            _packets.put(std::move(packet));
+        }
+
+        _packets.put(nullptr);
+    }
+
+    void decode_stage()
+    {
+        // Frame left over by an accurate seek goes first.
+        if (_vc._has_pending_frame)
+        {
+            _vc._has_pending_frame = false;
+            auto frame = _frame_pool.acquire();
+            if (frame && !_vc.is_dropped(_vc._src_frame) && _vc.decode())
+            {
+                av_frame_move_ref(frame.get(), _vc._tmp_frame);
+                _frames.put(std::move(frame));
+            }
+        }
+
+        while (true)
+        {
+            packet_ptr packet;
+            _packets.get(&packet);
+
+            if (_stop)
+            {
+                if (!packet)
+                    break;
+                continue;
+            }
+
+            // A null packet puts the decoder in draining mode: the remaining buffered frames are flushed out.
+            if (auto r = _vc._stats->measure(stage::decode, [&] { return avcodec_send_packet(_vc._codec_ctx, packet.get()); }); r < 0 && AVERROR(EAGAIN) != r)
+                if (_vc.is_error("avcodec_send_packet", r))
+                    _vc._stats->add(stats_recorder::counter::decode_errors);
+
+            while (true)
+            {
+                if (auto r = _vc._stats->measure(stage::decode, [&] { return avcodec_receive_frame(_vc._codec_ctx, _vc._src_frame); }); r < 0)
+                {
+                    if (AVERROR(EAGAIN) != r && AVERROR_EOF != r)
+                    {
+                        _vc.is_error("avcodec_receive_frame", r);
+                        _vc._stats->add(stats_recorder::counter::decode_errors);
+                    }
+                    break;
+                }
+
+                _vc._stats->add(stats_recorder::counter::frames_decoded);
+                _vc.set_first_frame_latency();
+                if (_vc.is_dropped(_vc._src_frame) || !_vc.decode())
+                    continue;
+
+                auto frame = _frame_pool.acquire();
+                if (!frame)
+                {
+                    log_error("av_frame_alloc");
+                    continue;
+                }
+
+                av_frame_move_ref(frame.get(), _vc._tmp_frame);
+                _frames.put(std::move(frame));
+            }
+
+            if (!packet)
+                break;
+        }
+
+        _frames.put(nullptr);
+    }
+
+    void convert_stage()
+    {
+        while (true)
+        {
+            frame_ptr frame;
+            _frames.get(&frame);
+
+            if (!frame)
+                break;
+
+            if (_stop)
+                continue;
+
+            auto output = _pool.acquire();
+            if (!_vc.retrieve(frame.get(), output->data.data()))
+                continue;
+
+            // Overflow policy applies here only: a slow consumer never stalls decoding unless the policy is block.
+            output->pts = _vc.get_timestamp(frame.get());
+            _output.put(std::move(output));
+        }
+
+        _output.put(nullptr, overflow_policy::block);
+    }
+
+    video_capture& _vc;
+    std::atomic_bool _stop;
+    std::atomic_bool _eos;
+
+    // Declared before the queues: packets and frames still queued are given back to them on destruction.
+    av_pool<AVPacket> _packet_pool;
+    av_pool<AVFrame> _frame_pool;
+    spsc_queue<packet_ptr> _packets;
+    spsc_queue<frame_ptr> _frames;
+    frame_queue<frame_pool::handle> _output;
+    frame_pool _pool;
+
+    std::thread _demux_thread;
+    std::thread _decode_thread;
+    std::thread _convert_thread;
+};
+
+}
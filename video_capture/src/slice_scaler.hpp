@@ -0,0 +1,178 @@
+#pragma once
+
+#include "logger.hpp"
+#include "image_utils.hpp"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+extern "C"
+{
+#include <libswscale/swscale.h>
+}
+
+namespace vc
+{
+class video_capture::slice_scaler
+{
+    struct slice
+    {
+        SwsContext* sws_ctx = nullptr;
+        int src_y = 0;
+        int src_h = 0;
+        int dst_y = 0;
+        int dst_h = 0;
+    };
+
+public:
+    explicit slice_scaler()
+        : _src_format{ AV_PIX_FMT_NONE }
+        , _dst_format{ AV_PIX_FMT_NONE }
+        , _generation{ 0 }
+        , _pending{ 0 }
+        , _stop{ false }
+    {
+    }
+
+    ~slice_scaler()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stop = true;
+        }
+        _start_cond.notify_all();
+
+        for (auto& t : _workers)
+            t.join();
+
+        for (auto& s : _slices)
+            sws_freeContext(s.sws_ctx);
+    }
+
+    bool init(int threads, int src_w, int src_h, AVPixelFormat src_format, int dst_w, int dst_h, AVPixelFormat dst_format, int flags)
+    {
+        _src_format = src_format;
+        _dst_format = dst_format;
+
+        // Each context sees its band as a standalone image: with a vertical resize every band would get its own scale factor
+        // (bands are rounded to chroma rows) and a filter seam at its borders, so only horizontal resizes are sliced.
+        if (src_h != dst_h)
+        {
+            log_error("Sliced colour conversion requires the same source and output height:", src_h, dst_h);
+            return false;
+        }
+
+        // Horizontal bands of rows: slice boundaries must fall on chroma rows of both source and destination.
+        const int alignment = std::max(get_chroma_alignment(src_format), get_chroma_alignment(dst_format));
+        const int n_slices = std::clamp(threads, 1, std::max(dst_h / (alignment * 8), 1));
+        const int rows_per_slice = (dst_h / n_slices + alignment - 1) / alignment * alignment;
+
+        for (int dst_y = 0; dst_y < dst_h; dst_y += rows_per_slice)
+        {
+            slice s;
+            s.dst_y = dst_y;
+            s.dst_h = std::min(rows_per_slice, dst_h - dst_y);
+
+            s.src_y = s.dst_y;
+            s.src_h = s.dst_h;
+
+            // One context per slice: each one sees its band as a standalone image, so they can run concurrently.
+            s.sws_ctx = sws_getContext(src_w, s.src_h, src_format, dst_w, s.dst_h, dst_format, flags, nullptr, nullptr, nullptr);
+            if (!s.sws_ctx)
+            {
+                log_error("Unable to initialize SwsContext for slice", _slices.size());
+                return false;
+            }
+
+            _slices.push_back(s);
+        }
+
+        // The calling thread converts the first slice, workers take care of the others.
+        for (size_t i = 1; i < _slices.size(); ++i)
+            _workers.emplace_back(&slice_scaler::worker, this, i);
+
+        log_info("Colour conversion split in", _slices.size(), "slices");
+        return true;
+    }
+
+    void set_colorspace_details(const AVFrame* frame)
+    {
+        for (auto& s : _slices)
+            vc::set_colorspace_details(s.sws_ctx, frame, _dst_format);
+    }
+
+    void scale(uint8_t* const src_data[4], const int src_linesize[4], uint8_t* const dst_data[4], const int dst_linesize[4])
+    {
+        {
+            std::lock_guard lock(_mutex);
+            std::copy_n(src_data, 4, _src_data);
+            std::copy_n(src_linesize, 4, _src_linesize);
+            std::copy_n(dst_data, 4, _dst_data);
+            std::copy_n(dst_linesize, 4, _dst_linesize);
+            _pending = _workers.size();
+            ++_generation;
+        }
+        _start_cond.notify_all();
+
+        scale_slice(_slices.front());
+
+        std::unique_lock lock(_mutex);
+        _done_cond.wait(lock, [this] { return _pending == 0; });
+    }
+
+private:
+    void worker(size_t index)
+    {
+        uint64_t generation = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(_mutex);
+                _start_cond.wait(lock, [this, generation] { return _stop || _generation != generation; });
+                if (_stop)
+                    return;
+                generation = _generation;
+            }
+
+            scale_slice(_slices[index]);
+
+            {
+                std::lock_guard lock(_mutex);
+                if (--_pending != 0)
+                    continue;
+            }
+            _done_cond.notify_one();
+        }
+    }
+
+    void scale_slice(const slice& s)
+    {
+        uint8_t* src[4] = {};
+        uint8_t* dst[4] = {};
+        offset_planes(_src_format, _src_data, _src_linesize, 0, s.src_y, src);
+        offset_planes(_dst_format, _dst_data, _dst_linesize, 0, s.dst_y, dst);
+        sws_scale(s.sws_ctx, src, _src_linesize, 0, s.src_h, dst, _dst_linesize);
+    }
+
+    AVPixelFormat _src_format;
+    AVPixelFormat _dst_format;
+    std::vector<slice> _slices;
+    std::vector<std::thread> _workers;
+
+    uint8_t* _src_data[4] = {};
+    int _src_linesize[4] = {};
+    uint8_t* _dst_data[4] = {};
+    int _dst_linesize[4] = {};
+
+    std::mutex _mutex;
+    std::condition_variable _start_cond;
+    std::condition_variable _done_cond;
+    uint64_t _generation;
+    size_t _pending;
+    bool _stop;
+};
+
+}
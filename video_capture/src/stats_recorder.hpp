@@ -0,0 +1,197 @@
+#pragma once
+
+#include <video_capture/stats.hpp>
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace vc
+{
+// Lock free recording: every sample is a couple of relaxed atomic increments, so the capture threads never wait on a reader.
+// Snapshots are not a single consistent cut across counters, which is fine for monitoring.
+// Without VIDEO_CAPTURE_STATS_ENABLED every call is an empty inline function and measure() just runs its callable.
+class video_capture::stats_recorder
+{
+public:
+    enum class counter { packets_read, bytes_read, frames_decoded, decode_errors, count };
+
+    explicit stats_recorder() { reset(); }
+
+    template<typename F>
+    auto measure([[maybe_unused]] stage s, F&& f)
+    {
+#if defined(VIDEO_CAPTURE_STATS_ENABLED)
+        const auto start = std::chrono::steady_clock::now();
+        if constexpr (std::is_void_v<decltype(f())>)
+        {
+            f();
+            record(s, std::chrono::steady_clock::now() - start);
+        }
+        else
+        {
+            auto result = f();
+            record(s, std::chrono::steady_clock::now() - start);
+            return result;
+        }
+#else
+        return f();
+#endif
+    }
+
+    void add([[maybe_unused]] counter c, [[maybe_unused]] uint64_t value = 1)
+    {
+#if defined(VIDEO_CAPTURE_STATS_ENABLED)
+        _counters[static_cast<size_t>(c)].fetch_add(value, std::memory_order_relaxed);
+#endif
+    }
+
+    void reset()
+    {
+        for (auto& h : _histograms)
+            h.reset();
+        for (auto& c : _counters)
+            c.store(0, std::memory_order_relaxed);
+        _start.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    stats get() const
+    {
+        stats s;
+#if defined(VIDEO_CAPTURE_STATS_ENABLED)
+        s.is_enabled = true;
+        s.elapsed = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::steady_clock::duration(_start.load(std::memory_order_relaxed));
+        s.read = _histograms[static_cast<size_t>(stage::read)].get();
+        s.decode = _histograms[static_cast<size_t>(stage::decode)].get();
+        s.transfer = _histograms[static_cast<size_t>(stage::transfer)].get();
+        s.convert = _histograms[static_cast<size_t>(stage::convert)].get();
+        s.packets_read = _counters[static_cast<size_t>(counter::packets_read)].load(std::memory_order_relaxed);
+        s.bytes_read = _counters[static_cast<size_t>(counter::bytes_read)].load(std::memory_order_relaxed);
+        s.frames_decoded = _counters[static_cast<size_t>(counter::frames_decoded)].load(std::memory_order_relaxed);
+        s.decode_errors = _counters[static_cast<size_t>(counter::decode_errors)].load(std::memory_order_relaxed);
+#endif
+        return s;
+    }
+
+private:
+    // Log-linear buckets: 8 per power of two, i.e. percentiles within 12.5% of the exact value, from 1 ns up to about 9 minutes.
+    class histogram
+    {
+        static constexpr int sub_bits = 3;
+        static constexpr int sub_count = 1 << sub_bits;
+        static constexpr int max_msb = 39;
+        static constexpr int bucket_count = (max_msb - sub_bits + 1) * sub_count + sub_count;
+
+    public:
+        void reset()
+        {
+            for (auto& b : _buckets)
+                b.store(0, std::memory_order_relaxed);
+            _count.store(0, std::memory_order_relaxed);
+            _total.store(0, std::memory_order_relaxed);
+            _min.store(UINT64_MAX, std::memory_order_relaxed);
+            _max.store(0, std::memory_order_relaxed);
+        }
+
+        void record(uint64_t ns)
+        {
+            _buckets[get_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+            _count.fetch_add(1, std::memory_order_relaxed);
+            _total.fetch_add(ns, std::memory_order_relaxed);
+
+            // Extremes only change at the very beginning of a stream: the compare exchange loop hardly ever spins.
+            for (auto min = _min.load(std::memory_order_relaxed); ns < min && !_min.compare_exchange_weak(min, ns, std::memory_order_relaxed);) { }
+            for (auto max = _max.load(std::memory_order_relaxed); ns > max && !_max.compare_exchange_weak(max, ns, std::memory_order_relaxed);) { }
+        }
+
+        stage_stats get() const
+        {
+            stage_stats s;
+            std::array<uint64_t, bucket_count> buckets;
+            uint64_t count = 0;
+            for (int i = 0; i < bucket_count; ++i)
+                count += buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+
+            if (count == 0)
+                return s;
+
+            s.count = _count.load(std::memory_order_relaxed);
+            s.total = std::chrono::nanoseconds(_total.load(std::memory_order_relaxed));
+            s.min = std::chrono::nanoseconds(_min.load(std::memory_order_relaxed));
+            s.max = std::chrono::nanoseconds(_max.load(std::memory_order_relaxed));
+
+            const auto percentile = [&](double p)
+            {
+                const auto rank = static_cast<uint64_t>(p * (count - 1)) + 1;
+                uint64_t cumulative = 0;
+                for (int i = 0; i < bucket_count; ++i)
+                    if (cumulative += buckets[i]; cumulative >= rank)
+                        return std::chrono::nanoseconds(std::clamp(get_value(i), s.min.count(), s.max.count()));
+                return s.max;
+            };
+
+            s.p50 = percentile(0.50);
+            s.p90 = percentile(0.90);
+            s.p99 = percentile(0.99);
+            return s;
+        }
+
+    private:
+        static int get_msb(uint64_t value)
+        {
+#if defined(_MSC_VER)
+            unsigned long index = 0;
+            _BitScanReverse64(&index, value);
+            return static_cast<int>(index);
+#else
+            return 63 - __builtin_clzll(value);
+#endif
+        }
+
+        static int get_bucket(uint64_t ns)
+        {
+            if (ns < sub_count)
+                return static_cast<int>(ns);
+
+            const int msb = std::min(get_msb(ns), max_msb);
+            const int shift = msb - sub_bits;
+            const int sub = static_cast<int>(std::min<uint64_t>(ns >> shift, 2 * sub_count - 1)) - sub_count;
+            return (shift + 1) * sub_count + sub;
+        }
+
+        // Middle of the bucket.
+        static int64_t get_value(int bucket)
+        {
+            if (bucket < sub_count)
+                return bucket;
+
+            const int shift = bucket / sub_count - 1;
+            const int64_t low = static_cast<int64_t>(sub_count + bucket % sub_count) << shift;
+            return low + ((int64_t{ 1 } << shift) >> 1);
+        }
+
+        std::array<std::atomic<uint64_t>, bucket_count> _buckets;
+        std::atomic<uint64_t> _count;
+        std::atomic<uint64_t> _total;
+        std::atomic<uint64_t> _min;
+        std::atomic<uint64_t> _max;
+    };
+
+    void record(stage s, std::chrono::steady_clock::duration elapsed)
+    {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        _histograms[static_cast<size_t>(s)].record(static_cast<uint64_t>(std::max<int64_t>(ns, 0)));
+    }
+
+    std::array<histogram, 4> _histograms;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(counter::count)> _counters;
+    std::atomic<std::chrono::steady_clock::rep> _start;
+};
+
+}
@@ -1,11 +1,21 @@
 #include <video_capture/video_capture.hpp>
 #include <video_capture/raw_frame.hpp>
+#include <video_capture/decoded_frame.hpp>
 
 #include "logger.hpp"
 #include "hw_acceleration.hpp"
+#include "pipeline.hpp"
+#include "slice_scaler.hpp"
+#include "yuv_to_rgb.hpp"
+#include "yuv_to_tensor.hpp"
+#include "image_utils.hpp"
+#include "packet_index.hpp"
+#include "stats_recorder.hpp"
+#include "memory_input.hpp"
 
 #include <thread>
 #include <chrono>
+#include <cmath>
 
 extern "C"
 {
@@ -15,13 +25,157 @@ extern "C"
 #include <libavutil/frame.h>
 #include <libavutil/buffer.h>
 #include <libavutil/hwcontext.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 }
 
 namespace vc
 {
+namespace
+{
+    AVPixelFormat to_av_pixel_format(pixel_format format)
+    {
+        switch (format)
+        {
+            case pixel_format::bgr24:   return AV_PIX_FMT_BGR24;
+            case pixel_format::rgb24:   return AV_PIX_FMT_RGB24;
+            case pixel_format::rgba:    return AV_PIX_FMT_RGBA;
+            case pixel_format::gray8:   return AV_PIX_FMT_GRAY8;
+            case pixel_format::yuv420p: return AV_PIX_FMT_YUV420P;
+            case pixel_format::nv12:    return AV_PIX_FMT_NV12;
+            default:                    return AV_PIX_FMT_NONE;
+        }
+    }
+
+    int to_sws_flags(scaling_algorithm algorithm)
+    {
+        switch (algorithm)
+        {
+            case scaling_algorithm::fast_bilinear: return SWS_FAST_BILINEAR;
+            case scaling_algorithm::bilinear:      return SWS_BILINEAR;
+            case scaling_algorithm::area:          return SWS_AREA;
+            case scaling_algorithm::bicubic:       return SWS_BICUBIC;
+            default:                               return SWS_BICUBIC;
+        }
+    }
+
+    bool is_same_layout(int src_format, int dst_format)
+    {
+        // Full range (JPEG) YUV has the very same memory layout of its limited range counterpart.
+        if (src_format == AV_PIX_FMT_YUVJ420P)
+            src_format = AV_PIX_FMT_YUV420P;
+
+        return src_format == dst_format;
+    }
+
+    // Conversions covered by the hand written kernels.
+    bool get_native_conversion(int src_format, int dst_format, bool& is_nv12, rgb_layout& layout)
+    {
+        if (src_format != AV_PIX_FMT_YUV420P && src_format != AV_PIX_FMT_YUVJ420P && src_format != AV_PIX_FMT_NV12)
+            return false;
+
+        switch (dst_format)
+        {
+            case AV_PIX_FMT_BGR24: layout = rgb_layout::bgr24; break;
+            case AV_PIX_FMT_RGB24: layout = rgb_layout::rgb24; break;
+            case AV_PIX_FMT_RGBA:  layout = rgb_layout::rgba;  break;
+            default: return false;
+        }
+
+        is_nv12 = src_format == AV_PIX_FMT_NV12;
+        return true;
+    }
+
+    // Options FFmpeg did not recognise are left in the dictionary: only the ones set by the user are reported.
+    video_capture::options_t get_unused_options(const AVDictionary* dict, const video_capture::options_t& user_options)
+    {
+        video_capture::options_t unused;
+        const AVDictionaryEntry* entry = nullptr;
+        while ((entry = av_dict_get(dict, "", entry, AV_DICT_IGNORE_SUFFIX)))
+            if (user_options.count(entry->key))
+                unused.emplace(entry->key, entry->value);
+        return unused;
+    }
+
+    // 8 bit YUV layouts sampled by the fused tensor kernel: planar with any chroma subsampling, or with interleaved chroma.
+    bool get_yuv_image(int format, uint8_t* const data[4], const int linesize[4], int width, int height, yuv_image& image)
+    {
+        const auto desc = av_pix_fmt_desc_get((AVPixelFormat)format);
+        if (!desc || desc->nb_components < 3 || (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_HWACCEL)))
+            return false;
+
+        const auto& y = desc->comp[0];
+        const auto& u = desc->comp[1];
+        const auto& v = desc->comp[2];
+        if (y.depth != 8 || u.depth != 8 || v.depth != 8 || y.step != 1 || u.plane == y.plane || u.step != v.step)
+            return false;
+
+        image.y = data[y.plane] + y.offset;
+        image.u = data[u.plane] + u.offset;
+        image.v = data[v.plane] + v.offset;
+        image.y_linesize = linesize[y.plane];
+        image.uv_linesize = linesize[u.plane];
+        image.uv_step = u.step;
+        image.log2_chroma_w = desc->log2_chroma_w;
+        image.log2_chroma_h = desc->log2_chroma_h;
+        image.width = width;
+        image.height = height;
+        return true;
+    }
+
+    // Planar counterpart of a packed output format, with its planes pointed at the channels of a CHW tensor.
+    // Planar RGB is stored by FFmpeg in G, B, R (, A) plane order.
+    AVPixelFormat get_planar_tensor(int packed_format, uint8_t* data, int plane_size, uint8_t* planes[4])
+    {
+        switch (packed_format)
+        {
+            case AV_PIX_FMT_RGB24:
+                planes[0] = data + plane_size;
+                planes[1] = data + 2 * plane_size;
+                planes[2] = data;
+                return AV_PIX_FMT_GBRP;
+
+            case AV_PIX_FMT_BGR24:
+                planes[0] = data + plane_size;
+                planes[1] = data;
+                planes[2] = data + 2 * plane_size;
+                return AV_PIX_FMT_GBRP;
+
+            case AV_PIX_FMT_RGBA:
+                planes[0] = data + plane_size;
+                planes[1] = data + 2 * plane_size;
+                planes[2] = data;
+                planes[3] = data + 3 * plane_size;
+                return AV_PIX_FMT_GBRAP;
+
+            case AV_PIX_FMT_GRAY8:
+                planes[0] = data;
+                return AV_PIX_FMT_GRAY8;
+
+            default:
+                return AV_PIX_FMT_NONE;
+        }
+    }
+}
+
 video_capture::video_capture() noexcept
     : _is_opened{ false }
+    , _output_format{ pixel_format::bgr24 }
+    , _conversion_threads{ 1 }
+    , _conversion_backend{ conversion_backend::swscale }
+    , _scaling_algorithm{ scaling_algorithm::bicubic }
+    , _keyframes_only{ false }
+    , _target_fps{ 0.0 }
+    , _keep_every{ 0 }
+    , _mean{ 0.0f, 0.0f, 0.0f }
+    , _std{ 1.0f, 1.0f, 1.0f }
+    , _letterbox{ false }
+    , _pad_value{ 114 }
+    , _latency_profile{ latency_profile::standard }
+    , _interrupt{ false }
     , _hw{std::make_unique<hw_acceleration>()}
+    , _stats{std::make_unique<stats_recorder>()}
+    , _tensor_scratch{std::make_unique<tensor_scratch>()}
 {
     init(); 
     av_log_set_level(0);
@@ -34,11 +188,166 @@ video_capture::~video_capture() noexcept
 
 void video_capture::set_log_callback(const log_callback_t& cb, const log_level& level) { vc::logger::get().set_log_callback(cb, level); }
 
+// Logger is shared by every capture: async mode moves the callbacks to a dedicated thread, off the decode path.
+void video_capture::set_log_mode(log_mode mode) { vc::logger::get().set_async(mode == log_mode::async); }
+
+void video_capture::set_output_pixel_format(pixel_format format)
+{
+    std::lock_guard lock(_open_mutex);
+    _output_format = format;
+}
+
+void video_capture::set_decode_threading(decode_threading threading, int thread_count)
+{
+    std::lock_guard lock(_open_mutex);
+    _decode_threading = std::make_tuple(threading, std::max(thread_count, 0));
+}
+
+void video_capture::set_conversion_threads(int thread_count)
+{
+    std::lock_guard lock(_open_mutex);
+    _conversion_threads = thread_count > 0 ? thread_count : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+void video_capture::set_conversion_backend(conversion_backend backend)
+{
+    std::lock_guard lock(_open_mutex);
+    _conversion_backend = backend;
+}
+
+void video_capture::set_output_size(int width, int height)
+{
+    std::lock_guard lock(_open_mutex);
+    
+    // Non positive sizes restore the default: frames are delivered at the source resolution.
+    if (width > 0 && height > 0)
+        _output_size = std::make_tuple(width, height);
+    else
+        _output_size.reset();
+}
+
+void video_capture::set_scaling_algorithm(scaling_algorithm algorithm)
+{
+    std::lock_guard lock(_open_mutex);
+    _scaling_algorithm = algorithm;
+}
+
+void video_capture::set_crop(int x, int y, int width, int height)
+{
+    std::lock_guard lock(_open_mutex);
+
+    // Non positive sizes disable cropping.
+    if (width > 0 && height > 0)
+        _crop = std::make_tuple(std::max(x, 0), std::max(y, 0), width, height);
+    else
+        _crop.reset();
+}
+
+void video_capture::set_keyframes_only(bool keyframes_only)
+{
+    std::lock_guard lock(_open_mutex);
+    _keyframes_only = keyframes_only;
+}
+
+void video_capture::set_target_fps(double fps)
+{
+    std::lock_guard lock(_open_mutex);
+
+    // Non positive rates disable decimation, the last call between set_target_fps() and set_keep_every() wins.
+    _target_fps = std::max(fps, 0.0);
+    _keep_every = 0;
+}
+
+void video_capture::set_keep_every(int n)
+{
+    std::lock_guard lock(_open_mutex);
+    _keep_every = n > 1 ? n : 0;
+    _target_fps = 0.0;
+}
+
+void video_capture::set_normalization(const std::array<float, 3>& mean, const std::array<float, 3>& std)
+{
+    std::lock_guard lock(_open_mutex);
+
+    // Pixels are scaled to [0, 1] first: value = (pixel / 255 - mean) / std, in the channel order of the output format.
+    if (std::any_of(std.begin(), std.end(), [](float s) { return !(s > 0.0f); }))
+    {
+        log_error("Normalization standard deviations must be positive");
+        return;
+    }
+
+    _mean = mean;
+    _std = std;
+}
+
+void video_capture::set_letterbox(bool letterbox, int pad_value)
+{
+    std::lock_guard lock(_open_mutex);
+    _letterbox = letterbox;
+    _pad_value = std::clamp(pad_value, 0, 255);
+}
+
+void video_capture::set_latency_profile(latency_profile profile)
+{
+    std::lock_guard lock(_open_mutex);
+    _latency_profile = profile;
+}
+
 bool video_capture::open(const std::string& video_path, decode_support decode_preference)
+{
+    return open(video_path, {}, {}, decode_preference);
+}
+
+bool video_capture::open(const std::string& video_path, const options_t& format_options, const options_t& codec_options, decode_support decode_preference)
+{
+    return open_input(video_path, nullptr, format_options, codec_options, decode_preference);
+}
+
+bool video_capture::open(const uint8_t* data, size_t size, decode_support decode_preference)
+{
+    return open(data, size, {}, {}, decode_preference);
+}
+
+bool video_capture::open(const uint8_t* data, size_t size, const options_t& format_options, const options_t& codec_options, decode_support decode_preference)
+{
+    auto input = std::make_unique<memory_input>();
+    if (!input->open(data, size))
+        return false;
+
+    log_info("Memory input:", size, "bytes");
+    return open_input({}, std::move(input), format_options, codec_options, decode_preference);
+}
+
+bool video_capture::open_mapped(const std::string& video_path, decode_support decode_preference)
+{
+    return open_mapped(video_path, {}, {}, decode_preference);
+}
+
+// Same as a plain open, except for the reads: the demuxer gets the mapped pages, no read() system call per buffer.
+// The path is kept, so sidecar packet indexes work as usual.
+bool video_capture::open_mapped(const std::string& video_path, const options_t& format_options, const options_t& codec_options, decode_support decode_preference)
+{
+    auto input = std::make_unique<memory_input>();
+    if (!input->open(video_path))
+        return false;
+
+    return open_input(video_path, std::move(input), format_options, codec_options, decode_preference);
+}
+
+bool video_capture::open_input(const std::string& video_path, std::unique_ptr<memory_input> input, const options_t& format_options, const options_t& codec_options, decode_support decode_preference)
 {
     std::lock_guard lock(_open_mutex);
     
     release();
+    const auto open_start = std::chrono::steady_clock::now();
+    _stats->reset();
+
+    // release() only handles opened captures: whatever a failed open allocated so far is freed on the way out.
+    struct open_guard
+    {
+        video_capture* vc;
+        ~open_guard() { if (!vc->_is_opened) vc->free_contexts(); }
+    } guard{ this };
 
     log_info("Opening video path:", video_path);
     log_info("HW acceleration", (decode_preference == decode_support::HW ? "required" : "not required"));
@@ -54,18 +363,61 @@ bool video_capture::open(const std::string& video_path, decode_support decode_pr
         return false;
     }
 
+    // Blocking network reads give up once the capture is interrupted (see capture_group::stop()), instead of waiting for the next packet.
+    _format_ctx->interrupt_callback = { [](void* opaque) { return static_cast<video_capture*>(opaque)->_interrupt ? 1 : 0; }, this };
+
+    // Custom IO: avformat_open_input() probes and demuxes through the memory input callbacks, the path (if any) is only a format hint.
+    if (input)
+    {
+        _memory_input = std::move(input);
+        _format_ctx->pb = _memory_input->get_context();
+        _format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
     if (auto r = av_dict_set(&_options, "rtsp_transport", "tcp", 0); r < 0)
     {
         log_error("av_dict_set", vc::logger::get().err2str(r));
         return false;
     }
 
+    // Live sources: no demuxer buffering and a short probe, stream parameters come from the very first packets.
+    // max_delay also bounds the RTP reordering queue of RTSP inputs.
+    if (_latency_profile == latency_profile::low_latency)
+    {
+        const std::pair<const char*, const char*> low_latency_options[] = {
+            { "fflags", "nobuffer" },
+            { "probesize", "32768" },
+            { "analyzeduration", "100000" },
+            { "max_delay", "0" } };
+
+        for (const auto& [key, value] : low_latency_options)
+        {
+            if (auto r = av_dict_set(&_options, key, value, 0); r < 0)
+            {
+                log_error("av_dict_set", vc::logger::get().err2str(r));
+                return false;
+            }
+        }
+    }
+
+    // User options come last: they override the defaults above.
+    for (const auto& [key, value] : format_options)
+    {
+        if (auto r = av_dict_set(&_options, key.c_str(), value.c_str(), 0); r < 0)
+        {
+            log_error("av_dict_set", key, vc::logger::get().err2str(r));
+            return false;
+        }
+    }
+
     if (auto r = avformat_open_input(&_format_ctx, video_path.c_str(), nullptr, &_options); r < 0)
     {
         log_error("avformat_open_input", vc::logger::get().err2str(r));
         return false;
     }
 
+    _unused_format_options = get_unused_options(_options, format_options);
+
     if (auto r = avformat_find_stream_info(_format_ctx, nullptr); r < 0)
     {
         log_error("avformat_find_stream_info");
@@ -98,7 +450,53 @@ bool video_capture::open(const std::string& video_path, decode_support decode_pr
         // _codec_ctx->hw_frames_ctx = _hw->get_frames_ctx(_codec_ctx->width, _codec_ctx->height);
     }
 
-    if (auto r = avcodec_open2(_codec_ctx, codec, nullptr); r < 0)
+    if (_decode_threading)
+    {
+        // A thread count of 0 lets FFmpeg pick the number of threads from the available cores.
+        const auto [threading, thread_count] = _decode_threading.value();
+        switch (threading)
+        {
+            case decode_threading::none:            _codec_ctx->thread_type = 0; break;
+            case decode_threading::frame:           _codec_ctx->thread_type = FF_THREAD_FRAME; break;
+            case decode_threading::slice:           _codec_ctx->thread_type = FF_THREAD_SLICE; break;
+            case decode_threading::frame_and_slice: _codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE; break;
+        }
+        _codec_ctx->thread_count = threading == decode_threading::none ? 1 : thread_count;
+    }
+
+    if (_latency_profile == latency_profile::low_latency)
+    {
+        // Frame threading holds back one frame per thread: slice threading only, unless threading was configured explicitly.
+        if (!_decode_threading)
+            _codec_ctx->thread_type = FF_THREAD_SLICE;
+
+        // Frames leave the decoder as soon as they are decoded. Streams with B-frames still need reordering, or frames would come out of order.
+        if (_format_ctx->streams[_stream_index]->codecpar->video_delay == 0)
+            _codec_ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        else
+            log_info("Low delay decoding not available: stream has B-frames");
+    }
+
+    // Keyframes only: non key packets are dropped before the decoder (see grab()), this also covers decoders that get them anyway.
+    if (_keyframes_only)
+        _codec_ctx->skip_frame = AVDISCARD_NONKEY;
+
+    // Codec options are applied by avcodec_open2(), after the settings above (e.g. "threads" wins over set_decode_threading()).
+    AVDictionary* codec_dict = nullptr;
+    for (const auto& [key, value] : codec_options)
+    {
+        if (auto r = av_dict_set(&codec_dict, key.c_str(), value.c_str(), 0); r < 0)
+        {
+            log_error("av_dict_set", key, vc::logger::get().err2str(r));
+            av_dict_free(&codec_dict);
+            return false;
+        }
+    }
+
+    const auto r = avcodec_open2(_codec_ctx, codec, &codec_dict);
+    _unused_codec_options = get_unused_options(codec_dict, codec_options);
+    av_dict_free(&codec_dict);
+    if (r < 0)
     {
         log_error("avcodec_open2", vc::logger::get().err2str(r));
         return false;
@@ -137,22 +535,113 @@ bool video_capture::open(const std::string& video_path, decode_support decode_pr
         _tmp_frame = _src_frame;
     }
 
-    _dst_frame->format = AVPixelFormat::AV_PIX_FMT_BGR24;
-	_dst_frame->width  = _codec_ctx->width;
-	_dst_frame->height = _codec_ctx->height;
-    if (auto r = av_frame_get_buffer(_dst_frame, 0); r < 0)
+    // Region of the decoded frame that gets converted: its origin is moved back to the closest chroma sample,
+    // so that every plane can be offset in place (HW frames are transferred as NV12, hence 4:2:0 at least).
+    _src_rect = std::make_tuple(0, 0, _codec_ctx->width, _codec_ctx->height);
+    if (_crop)
+    {
+        const auto alignment = std::max(get_chroma_alignment(_codec_ctx->pix_fmt), 2);
+        auto [x, y, w, h] = _crop.value();
+        x = std::min(x / alignment * alignment, _codec_ctx->width);
+        y = std::min(y / alignment * alignment, _codec_ctx->height);
+        w = std::min(w, _codec_ctx->width - x);
+        h = std::min(h, _codec_ctx->height - y);
+        if (w <= 0 || h <= 0)
+        {
+            log_error("Crop rectangle is outside of the frame");
+            return false;
+        }
+        _src_rect = std::make_tuple(x, y, w, h);
+    }
+
+    // Destination frame is a single contiguous buffer (no row padding), so that read(uint8_t**) hands out packed planes.
+    // Cropping and resizing happen in the very same pass of the colour conversion.
+    const auto [src_x, src_y, src_width, src_height] = _src_rect;
+    const auto [dst_width, dst_height] = _output_size.value_or(std::make_tuple(src_width, src_height));
+    _dst_frame->format = to_av_pixel_format(_output_format);
+    _dst_frame->width  = dst_width;
+    _dst_frame->height = dst_height;
+    // Float tensors can keep the aspect ratio of the source: the image is centred and the bands around it padded.
+    _letterbox_rect = std::make_tuple(0, 0, dst_width, dst_height);
+    if (_letterbox)
+    {
+        const double scale = std::min(static_cast<double>(dst_width) / src_width, static_cast<double>(dst_height) / src_height);
+        const int w = std::clamp(static_cast<int>(std::lround(src_width * scale)), 1, dst_width);
+        const int h = std::clamp(static_cast<int>(std::lround(src_height * scale)), 1, dst_height);
+        _letterbox_rect = std::make_tuple((dst_width - w) / 2, (dst_height - h) / 2, w, h);
+    }
+
+    const auto dst_size = av_image_get_buffer_size((AVPixelFormat)_dst_frame->format, _dst_frame->width, _dst_frame->height, 1);
+    if (dst_size < 0)
+    {
+        log_error("av_image_get_buffer_size", vc::logger::get().err2str(dst_size));
+        return false;
+    }
+
+    if (_dst_frame->buf[0] = av_buffer_alloc(dst_size); !_dst_frame->buf[0])
+    {
+        log_error("av_buffer_alloc");
+        return false;
+    }
+
+    if (auto r = av_image_fill_arrays(_dst_frame->data, _dst_frame->linesize, _dst_frame->buf[0]->data, (AVPixelFormat)_dst_frame->format, _dst_frame->width, _dst_frame->height, 1); r < 0)
     {
-        log_error("av_frame_get_buffer", vc::logger::get().err2str(r));
+        log_error("av_image_fill_arrays", vc::logger::get().err2str(r));
         return false;
     }
 
     _is_opened = true;
+    _video_path = video_path;
+    _open_time = std::chrono::steady_clock::now() - open_start;
+
+    // Decimation is pts based whenever the frame rate is known, so that it copes with variable frame rate and dropped frames.
+    const auto frame_rate = _format_ctx->streams[_stream_index]->avg_frame_rate;
+    const auto fps = frame_rate.num > 0 && frame_rate.den > 0 ? static_cast<double>(frame_rate.num) / frame_rate.den : 0.0;
+    _decimation = {};
+    if (_target_fps > 0.0)
+        _decimation.interval = 1.0 / _target_fps;
+    else if (_keep_every > 1 && fps > 0.0)
+        _decimation.interval = _keep_every / fps;
+    else if (_keep_every > 1)
+        _decimation.keep_every = _keep_every;
+
+    if (_decimation.interval > 0.0)
+    {
+        _decimation.tolerance = fps > 0.0 ? 0.5 / fps : 0.001;
+
+        // Keeping at most one frame out of four: even the sparsest usual GOP structures (IBBBP) leave enough reference frames,
+        // so non reference ones are discarded by the decoder without being decoded at all.
+        if (fps > 0.0 && _decimation.interval * fps >= 4.0 && !_keyframes_only)
+            _codec_ctx->skip_frame = AVDISCARD_NONREF;
+    }
+
+    // A sidecar index left by a previous build_index() makes seeks and frame counting exact lookups.
+    if (auto index = std::make_unique<packet_index>(); !video_path.empty() && index->load(packet_index::get_default_path(video_path), _format_ctx, _stream_index))
+        _index = std::move(index);
+
     log_info("Opened video path:", video_path);
     log_info("Frame Width:", _codec_ctx->width, "px");
     log_info("Frame Height:", _codec_ctx->height, "px");
+    log_info("Crop:", src_x, src_y, src_width, "x", src_height, "px");
+    log_info("Output Size:", _dst_frame->width, "x", _dst_frame->height, "px");
+    log_info("Pixel Format:", av_get_pix_fmt_name((AVPixelFormat)_dst_frame->format));
+    log_info("Letterbox:", std::get<0>(_letterbox_rect), std::get<1>(_letterbox_rect), std::get<2>(_letterbox_rect), "x", std::get<3>(_letterbox_rect), "px");
+    log_info("Conversion Backend:", (_conversion_backend == conversion_backend::native ? get_yuv_kernels().name : "swscale"));
+    log_info("Decoder Threads:", _codec_ctx->thread_count, (_codec_ctx->active_thread_type & FF_THREAD_FRAME ? "(frame)" : _codec_ctx->active_thread_type & FF_THREAD_SLICE ? "(slice)" : "(none)"));
     log_info("Frame Rate:", (get_fps() != std::nullopt ? get_fps().value() : -1), "fps");
     log_info("Duration:", (get_duration() != std::nullopt ? std::chrono::duration_cast<std::chrono::seconds>(get_duration().value()).count() : -1), "sec");
     log_info("Number of frames:", (get_frame_count() != std::nullopt ? get_frame_count().value() : -1));
+    log_info("Latency Profile:", (_latency_profile == latency_profile::low_latency ? "low latency" : "standard"));
+    log_info("Demuxer:", "nobuffer", (_format_ctx->flags & AVFMT_FLAG_NOBUFFER ? "yes" : "no"), "probesize", _format_ctx->probesize,
+        "analyzeduration", _format_ctx->max_analyze_duration, "max_delay", _format_ctx->max_delay);
+    for (const auto& [key, value] : _unused_format_options)
+        log_info("Unused format option:", key, "=", value);
+    for (const auto& [key, value] : _unused_codec_options)
+        log_info("Unused codec option:", key, "=", value);
+    log_info("Open Time:", std::chrono::duration_cast<std::chrono::milliseconds>(_open_time).count(), "ms");
+    log_info("Packet Index:", (_index ? "loaded" : "not available"));
+    log_info("Keyframes Only:", (_keyframes_only ? "yes" : "no"));
+    log_info("Decimation:", (_decimation.interval > 0.0 ? 1.0 / _decimation.interval : 0.0), "fps", "keep every", _decimation.keep_every);
     log_info("Video Capture is initialized");
 
     return true;
@@ -171,6 +660,9 @@ auto video_capture::get_frame_count() const -> std::optional<int>
         return std::nullopt;
     }
 
+    if (_index)
+        return std::make_optional(static_cast<int>(_index->size()));
+
     auto nb_frames = _format_ctx->streams[_stream_index]->nb_frames;
     if (!nb_frames)
     {
@@ -204,7 +696,8 @@ auto video_capture::get_frame_size() const -> std::optional<std::tuple<int, int>
         return std::nullopt;
     }
     
-    auto size = std::make_tuple(_codec_ctx->width, _codec_ctx->height);
+    // Size of the frames handed out by read(), i.e. after resizing.
+    auto size = std::make_tuple(_dst_frame->width, _dst_frame->height);
     return std::make_optional(size);
 }
 
@@ -216,7 +709,7 @@ auto video_capture::get_frame_size_in_bytes() const -> std::optional<int>
         return std::nullopt;
     }
 
-    auto bytes = _codec_ctx->width * _codec_ctx->height * 3;
+    auto bytes = av_image_get_buffer_size((AVPixelFormat)_dst_frame->format, _dst_frame->width, _dst_frame->height, 1);
     return std::make_optional(bytes);
 }
 
@@ -239,6 +732,83 @@ auto video_capture::get_fps() const -> std::optional<double>
     return std::make_optional(fps);
 }
 
+auto video_capture::get_output_pixel_format() const -> pixel_format
+{
+    return _output_format;
+}
+
+auto video_capture::get_conversion_backend() const -> conversion_backend
+{
+    return _conversion_backend;
+}
+
+auto video_capture::get_scaling_algorithm() const -> scaling_algorithm
+{
+    return _scaling_algorithm;
+}
+
+auto video_capture::get_crop() const -> std::optional<std::tuple<int, int, int, int>>
+{
+    if(!_is_opened)
+    {
+        log_error("Crop not available. Video path must be opened first.");
+        return std::nullopt;
+    }
+
+    // Effective rectangle, after alignment to chroma samples and clipping to the frame.
+    return std::make_optional(_src_rect);
+}
+
+auto video_capture::get_letterbox_rect() const -> std::optional<std::tuple<int, int, int, int>>
+{
+    if(!_is_opened)
+    {
+        log_error("Letterbox rectangle not available. Video path must be opened first.");
+        return std::nullopt;
+    }
+
+    // Where the image lands in the float tensor: maps detections back to the source frame.
+    return std::make_optional(_letterbox_rect);
+}
+
+auto video_capture::get_keyframe_index(int64_t frame_index) const -> std::optional<int64_t>
+{
+    if(!_index)
+    {
+        log_error("Keyframe index not available. Packet index must be built or loaded first.");
+        return std::nullopt;
+    }
+
+    if(frame_index < 0 || frame_index >= static_cast<int64_t>(_index->size()))
+        return std::nullopt;
+
+    if (auto keyframe = _index->find_keyframe(static_cast<size_t>(frame_index)))
+        return std::make_optional(static_cast<int64_t>(keyframe.value()));
+
+    return std::nullopt;
+}
+
+auto video_capture::get_decode_threading() const -> std::optional<std::tuple<decode_threading, int>>
+{
+    if(!_is_opened)
+    {
+        log_error("Decode threading not available. Video path must be opened first.");
+        return std::nullopt;
+    }
+
+    // Report what the decoder actually runs with, which might differ from the requested mode (e.g. codec without frame threading support).
+    auto threading = decode_threading::none;
+    if ((_codec_ctx->active_thread_type & FF_THREAD_FRAME) && (_codec_ctx->active_thread_type & FF_THREAD_SLICE))
+        threading = decode_threading::frame_and_slice;
+    else if (_codec_ctx->active_thread_type & FF_THREAD_FRAME)
+        threading = decode_threading::frame;
+    else if (_codec_ctx->active_thread_type & FF_THREAD_SLICE)
+        threading = decode_threading::slice;
+
+    const auto thread_count = threading == decode_threading::none ? 1 : _codec_ctx->thread_count;
+    return std::make_optional(std::make_tuple(threading, thread_count));
+}
+
 bool video_capture::is_error(const char* func_name, const int error) const
 {
     if(AVERROR_EOF == error) 
@@ -253,49 +823,106 @@ bool video_capture::is_error(const char* func_name, const int error) const
 
 bool video_capture::grab()
 {
+    // An accurate seek already decoded the frame that must come next.
+    if (_has_pending_frame)
+    {
+        _has_pending_frame = false;
+        return true;
+    }
+
+    set_first_read();
     while(true)
     {
         av_packet_unref(_packet);
-        if(auto r = av_read_frame(_format_ctx, _packet); r < 0)
+        bool is_eof = false;
+        if(auto r = _stats->measure(stage::read, [this] { return av_read_frame(_format_ctx, _packet); }); r < 0)
         {
             if (AVERROR(EAGAIN) == r)
                 continue; 
 
             if(is_error("av_read_frame", r))
                 return false;
+
+            is_eof = true;
+        }
+        else
+        {
+            _stats->add(stats_recorder::counter::packets_read);
+            _stats->add(stats_recorder::counter::bytes_read, _packet->size);
         }
 
-        if (_packet->stream_index != _stream_index)
+        // At end of stream the empty packet goes to the decoder as is, to drain its buffered frames.
+        if (!is_eof && _packet->stream_index != _stream_index)
+            continue;
+
+        if (!is_eof && _keyframes_only && !(_packet->flags & AV_PKT_FLAG_KEY))
             continue;
 
-        if (auto r = avcodec_send_packet(_codec_ctx, _packet); r < 0)
+        if (auto r = _stats->measure(stage::decode, [this] { return avcodec_send_packet(_codec_ctx, _packet); }); r < 0)
         {
             if (AVERROR(EAGAIN) == r)                         
                 continue; 
             
             if(is_error("avcodec_send_packet", r))
+            {
+                _stats->add(stats_recorder::counter::decode_errors);
                 return false;
+            }
         }
 
-        if (auto r = avcodec_receive_frame(_codec_ctx, _src_frame); r < 0)
+        if (auto r = _stats->measure(stage::decode, [this] { return avcodec_receive_frame(_codec_ctx, _src_frame); }); r < 0)
         {
             if (AVERROR(EAGAIN) == r)                         
                 continue; 
             
+            if (AVERROR_EOF != r)
+                _stats->add(stats_recorder::counter::decode_errors);
+
             log_info("avcodec_receive_frame", vc::logger::get().err2str(r));
             // release();
             return false;
         }
-        
+
+        _stats->add(stats_recorder::counter::frames_decoded);
+        set_first_frame_latency();
         return true;
     }
 }
 
+bool video_capture::grab_decimated()
+{
+    // Dropped frames never reach decode() and retrieve(): no HW transfer and no colour conversion.
+    while (grab())
+    {
+        if (!is_dropped(_src_frame))
+            return true;
+    }
+    return false;
+}
+
+bool video_capture::is_dropped(const AVFrame* frame)
+{
+    if (_decimation.keep_every > 1)
+        return (_decimation.count++ % _decimation.keep_every) != 0;
+
+    if (_decimation.interval <= 0.0 || frame->best_effort_timestamp == AV_NOPTS_VALUE)
+        return false;
+
+    const auto pts = get_timestamp(frame);
+    if (_decimation.next_pts && pts < _decimation.next_pts.value() - _decimation.tolerance)
+        return true;
+
+    // Resynchronize after gaps (e.g. seek or lost frames) instead of letting through a burst of frames.
+    const bool is_late = !_decimation.next_pts || pts - _decimation.next_pts.value() > _decimation.interval;
+    _decimation.next_pts = (is_late ? pts : _decimation.next_pts.value()) + _decimation.interval;
+    return false;
+}
+
 bool video_capture::decode()
 {
     if (_src_frame->format == _hw->hw_pixel_format)
     {
-        if (auto r = av_hwframe_transfer_data(_tmp_frame, _src_frame, 0); r < 0)
+        if (auto r = _stats->measure(stage::transfer, [this] { return av_hwframe_transfer_data(_tmp_frame, _src_frame, 0); }); r < 0)
         {
             log_error("av_hwframe_transfer_data", vc::logger::get().err2str(r));
             return false;
@@ -315,38 +942,143 @@ bool video_capture::decode()
     return true;
 }
 
-bool video_capture::retrieve()
+bool video_capture::retrieve(const AVFrame* frame, uint8_t* data)
 {
-    if (!_sws_ctx)
+    uint8_t* dst_data[4] = {};
+    int dst_linesize[4] = {};
+    if (auto r = av_image_fill_arrays(dst_data, dst_linesize, data, (AVPixelFormat)_dst_frame->format, _dst_frame->width, _dst_frame->height, 1); r < 0)
     {
-        _sws_ctx = sws_getCachedContext(_sws_ctx,
-            _codec_ctx->width, _codec_ctx->height, (AVPixelFormat)_tmp_frame->format,
-            _codec_ctx->width, _codec_ctx->height, AVPixelFormat::AV_PIX_FMT_BGR24,
-            SWS_BICUBIC, nullptr, nullptr, nullptr);
-        
+        log_error("av_image_fill_arrays", vc::logger::get().err2str(r));
+        return false;
+    }
+
+    return retrieve(frame, dst_data, dst_linesize, _dst_frame->format);
+}
+
+bool video_capture::retrieve(const AVFrame* frame, uint8_t* dst_data[4], int dst_linesize[4], int dst_format)
+{
+    // Scalers are bound to their output format: rebuild them when switching between packed and planar outputs.
+    if (dst_format != _scaler_format)
+    {
+        _slice_scaler.reset();
+        sws_freeContext(_sws_ctx);
+        _sws_ctx = nullptr;
+        _scaler_format = dst_format;
+    }
+
+    // Cropping only moves the source plane pointers: pixels outside of the region are never read.
+    const auto [src_x, src_y, src_width, src_height] = _src_rect;
+    uint8_t* src_data[4] = {};
+    offset_planes((AVPixelFormat)frame->format, frame->data, frame->linesize, src_x, src_y, src_data);
+
+    // Decoder already outputs the requested format and size: hand back its planes, no colour conversion needed.
+    const bool is_resized = src_width != _dst_frame->width || src_height != _dst_frame->height;
+    if (!is_resized && is_same_layout(frame->format, dst_format))
+    {
+        _stats->measure(stage::convert, [&] { av_image_copy(dst_data, dst_linesize, const_cast<const uint8_t**>(src_data), frame->linesize,
+            (AVPixelFormat)dst_format, _dst_frame->width, _dst_frame->height); });
+        return true;
+    }
+
+    // Hand written kernels: only for the plain colour conversions they implement, anything else falls back to swscale.
+    bool is_nv12 = false;
+    rgb_layout layout = rgb_layout::bgr24;
+    if (_conversion_backend == conversion_backend::native && !is_resized
+        && get_native_conversion(frame->format, dst_format, is_nv12, layout))
+    {
+        const auto coefficients = get_yuv_coefficients(get_yuv_matrix(frame), is_full_range(frame));
+        _stats->measure(stage::convert, [&] { yuv_to_rgb(src_data, frame->linesize, is_nv12, _dst_frame->width, _dst_frame->height, dst_data[0], dst_linesize[0], layout, coefficients); });
+        return true;
+    }
+
+    // Slices keep the geometry of the whole image only without vertical resize: other sizes use a single context.
+    if (_conversion_threads > 1 && src_height == _dst_frame->height)
+    {
+        if (!_slice_scaler)
+        {
+            auto scaler = std::make_unique<slice_scaler>();
+            if (!scaler->init(_conversion_threads,
+                src_width, src_height, (AVPixelFormat)frame->format,
+                _dst_frame->width, _dst_frame->height, (AVPixelFormat)dst_format,
+                to_sws_flags(_scaling_algorithm)))
+            {
+                log_error("Unable to initialize sliced colour conversion");
+                return false;
+            }
+            scaler->set_colorspace_details(frame);
+            _slice_scaler = std::move(scaler);
+        }
+
+        _stats->measure(stage::convert, [&] { _slice_scaler->scale(src_data, frame->linesize, dst_data, dst_linesize); });
+        return true;
+    }
+
+    if (!_sws_ctx)
+    {
+        _sws_ctx = sws_getCachedContext(_sws_ctx,
+            src_width, src_height, (AVPixelFormat)frame->format,
+            _dst_frame->width, _dst_frame->height, (AVPixelFormat)dst_format,
+            to_sws_flags(_scaling_algorithm), nullptr, nullptr, nullptr);
+        
         if (!_sws_ctx)
         {
             log_error("Unable to initialize SwsContext");
             return false;
         }
+
+        set_colorspace_details(_sws_ctx, frame, (AVPixelFormat)dst_format);
     }
 
-    _dst_frame->linesize[0] = _codec_ctx->width * 3;
-    sws_scale(_sws_ctx, _tmp_frame->data, _tmp_frame->linesize,
-        0, _codec_ctx->height, _dst_frame->data, _dst_frame->linesize);
+    _stats->measure(stage::convert, [&] { sws_scale(_sws_ctx, src_data, frame->linesize,
+        0, std::get<3>(_src_rect), dst_data, dst_linesize); });
 
     return true;
 }
 
+bool video_capture::retrieve(const AVFrame* frame, float* data)
+{
+    const auto [src_x, src_y, src_width, src_height] = _src_rect;
+    uint8_t* src_data[4] = {};
+    offset_planes((AVPixelFormat)frame->format, frame->data, frame->linesize, src_x, src_y, src_data);
+
+    yuv_image image = {};
+    if (!get_yuv_image(frame->format, src_data, frame->linesize, src_width, src_height, image))
+    {
+        log_error("Float output is not available for", av_get_pix_fmt_name((AVPixelFormat)frame->format), "frames, 8 bit YUV is required");
+        return false;
+    }
+
+    const auto [x, y, w, h] = _letterbox_rect;
+    const tensor_geometry geometry{ _dst_frame->width, _dst_frame->height, x, y, w, h };
+
+    tensor_normalization normalization = {};
+    for (int c = 0; c < 3; ++c)
+    {
+        normalization.scale[c] = 1.0f / (255.0f * _std[c]);
+        normalization.offset[c] = -_mean[c] / _std[c];
+        normalization.pad[c] = _pad_value * normalization.scale[c] + normalization.offset[c];
+    }
+
+    const auto coefficients = get_yuv_coefficients(get_yuv_matrix(frame), is_full_range(frame));
+    _stats->measure(stage::convert, [&] { yuv_to_tensor(image, data, geometry, _dst_frame->format == AV_PIX_FMT_BGR24, coefficients, normalization, *_tensor_scratch); });
+    return true;
+}
+
 bool video_capture::read(uint8_t** data)
 {
-    if(!grab())
+    if(_pipeline)
+    {
+        log_error("read(uint8_t**) is not available while the decode pipeline is running");
+        return false;
+    }
+
+    if(!grab_decimated())
         return false;
 
     if(!decode())
         return false;
 
-    if(!retrieve())
+    if(!retrieve(_tmp_frame, _dst_frame->data[0]))
         return false;
 
     *data = _dst_frame->data[0];
@@ -355,28 +1087,464 @@ bool video_capture::read(uint8_t** data)
 
 bool video_capture::read(raw_frame* frame)
 {
-    if(!grab())
+    if(_pipeline)
+        return _pipeline->read(frame);
+
+    if(!grab_decimated())
         return false;
 
     if(!decode())
         return false;
 
-    _dst_frame->data[0] = frame->data.data();
-    if(!retrieve())
+    if(!retrieve(_tmp_frame, frame->data.data()))
         return false;
 
+    frame->pts = get_timestamp(_tmp_frame);
+    return true;
+}
+
+// Planar float32 tensor (3 x height x width) straight from the decoded YUV planes, see set_normalization() and set_letterbox().
+bool video_capture::read(float* data)
+{
+    if(_pipeline)
+    {
+        log_error("read(float*) is not available while the decode pipeline is running");
+        return false;
+    }
+
+    if(_output_format != pixel_format::rgb24 && _output_format != pixel_format::bgr24)
+    {
+        log_error("read(float*) is only available for RGB24 and BGR24 output formats");
+        return false;
+    }
+
+    if(!grab_decimated())
+        return false;
+
+    if(!decode())
+        return false;
+
+    return retrieve(_tmp_frame, data);
+}
+
+bool video_capture::read(decoded_frame* frame)
+{
+    if(_pipeline)
+    {
+        log_error("read(decoded_frame*) is not available while the decode pipeline is running");
+        return false;
+    }
+
+    if(!grab_decimated())
+        return false;
+
+    if(!decode())
+        return false;
+
+    if (!frame->_frame)
+    {
+        if (frame->_frame = av_frame_alloc(); !frame->_frame)
+        {
+            log_error("av_frame_alloc");
+            return false;
+        }
+    }
+
+    // Hand the decoder's reference counted buffers over to the caller: no copy and no colour conversion.
+    // The decoder allocates fresh buffers for the next frame, so these stay valid until the handle is released.
+    frame->_pts = get_timestamp(_tmp_frame);
+    av_frame_unref(frame->_frame);
+    av_frame_move_ref(frame->_frame, _tmp_frame);
+    return true;
+}
+
+// Frames are converted straight into their slot of the batch: the stride between two frames is get_frame_size_in_bytes().
+// NCHW batches are written through the planar variant of the output format, so no extra transposition pass is needed.
+size_t video_capture::read_batch(size_t n, uint8_t* buffer, double* pts, tensor_layout layout)
+{
+    if(_pipeline)
+    {
+        log_error("read_batch is not available while the decode pipeline is running");
+        return 0;
+    }
+
+    if(!_is_opened)
+    {
+        log_error("read_batch not available. Video path must be opened first.");
+        return 0;
+    }
+
+    const auto plane_size = _dst_frame->width * _dst_frame->height;
+    const auto frame_size = static_cast<size_t>(get_frame_size_in_bytes().value());
+
+    size_t count = 0;
+    for (; count < n; ++count)
+    {
+        auto data = buffer + count * frame_size;
+        uint8_t* dst_data[4] = {};
+        int dst_linesize[4] = {};
+        int dst_format = _dst_frame->format;
+        if (layout == tensor_layout::nchw)
+        {
+            if (dst_format = get_planar_tensor(_dst_frame->format, data, plane_size, dst_data); dst_format == AV_PIX_FMT_NONE)
+            {
+                log_error("NCHW layout is only available for RGB, BGR, RGBA and GRAY output formats");
+                return 0;
+            }
+
+            for (int i = 0; i < 4; ++i)
+                dst_linesize[i] = dst_data[i] ? _dst_frame->width : 0;
+        }
+        else if (auto r = av_image_fill_arrays(dst_data, dst_linesize, data, (AVPixelFormat)dst_format, _dst_frame->width, _dst_frame->height, 1); r < 0)
+        {
+            log_error("av_image_fill_arrays", vc::logger::get().err2str(r));
+            return count;
+        }
+
+        if(!grab_decimated())
+            break;
+
+        if(!decode())
+            break;
+
+        if(!retrieve(_tmp_frame, dst_data, dst_linesize, dst_format))
+            break;
+
+        if (pts)
+            pts[count] = get_timestamp(_tmp_frame);
+    }
+
+    return count;
+}
+
+bool video_capture::seek(std::chrono::steady_clock::duration timestamp, seek_mode mode)
+{
+    std::lock_guard lock(_open_mutex);
+
+    if(!_is_opened)
+    {
+        log_error("Seek not available. Video path must be opened first.");
+        return false;
+    }
+
+    // Same clock of the timestamps reported by read().
     const auto time_base = _format_ctx->streams[_stream_index]->time_base;
-    frame->pts = _tmp_frame->best_effort_timestamp * static_cast<double>(time_base.num) / static_cast<double>(time_base.den);
-    
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(timestamp).count();
+    const auto pts = av_rescale_q(us, AVRational{ 1, AV_TIME_BASE }, time_base);
+
+    // With an index the exact frame timestamp is known upfront, and targets past the end are rejected without decoding.
+    if (_index)
+    {
+        const auto frame_index = _index->find_frame(pts);
+        if (!frame_index)
+        {
+            log_error("Unable to seek: timestamp is past the last frame");
+            return false;
+        }
+        const auto frame_pts = (*_index)[frame_index.value()].pts;
+        return seek_to_pts(frame_pts, frame_pts, mode);
+    }
+
+    return seek_to_pts(pts, pts, mode);
+}
+
+bool video_capture::seek(int64_t frame_index, seek_mode mode)
+{
+    std::lock_guard lock(_open_mutex);
+
+    if(!_is_opened)
+    {
+        log_error("Seek not available. Video path must be opened first.");
+        return false;
+    }
+
+    if (_index)
+    {
+        if (frame_index < 0 || frame_index >= static_cast<int64_t>(_index->size()))
+        {
+            log_error("Unable to seek to frame", frame_index, ": index out of range");
+            return false;
+        }
+        const auto frame_pts = (*_index)[static_cast<size_t>(frame_index)].pts;
+        return seek_to_pts(frame_pts, frame_pts, mode);
+    }
+
+    const auto stream = _format_ctx->streams[_stream_index];
+    const auto frame_rate = stream->avg_frame_rate;
+    if(frame_index < 0 || frame_rate.num <= 0 || frame_rate.den <= 0)
+    {
+        log_error("Unable to seek to frame", frame_index, ": invalid index or unknown frame rate");
+        return false;
+    }
+
+    // Frame timestamps are rounded to the stream time base: accept anything within half a frame before the nominal one.
+    const auto start_time = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    const auto pts = start_time + av_rescale_q(frame_index, AVRational{ frame_rate.den, frame_rate.num }, stream->time_base);
+    const auto min_pts = start_time + av_rescale_q(2 * frame_index - 1, AVRational{ frame_rate.den, 2 * frame_rate.num }, stream->time_base);
+    return seek_to_pts(pts, min_pts, mode);
+}
+
+// Indexing demuxes the whole input through the capture's own context: the capture is rewound afterwards, next read() returns the first frame.
+bool video_capture::build_index(const std::string& index_path)
+{
+    std::lock_guard lock(_open_mutex);
+
+    if(!_is_opened)
+    {
+        log_error("Packet index not available. Video path must be opened first.");
+        return false;
+    }
+
+    if(_pipeline)
+    {
+        log_error("build_index() is not available while the decode pipeline is running");
+        return false;
+    }
+
+    if(!_format_ctx->pb || !(_format_ctx->pb->seekable & AVIO_SEEKABLE_NORMAL))
+    {
+        log_error("Packet index is only available for seekable inputs (files), not for streams");
+        return false;
+    }
+
+    if(index_path.empty() && _video_path.empty())
+    {
+        log_error("Packet index path is required for memory inputs");
+        return false;
+    }
+
+    const auto path = index_path.empty() ? packet_index::get_default_path(_video_path) : index_path;
+    const auto is_built = packet_index::build(_format_ctx, _stream_index, path);
+
+    const auto stream = _format_ctx->streams[_stream_index];
+    const auto start_time = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    if (!seek_to_pts(start_time, start_time, seek_mode::fast) || !is_built)
+        return false;
+
+    auto index = std::make_unique<packet_index>();
+    if (!index->load(path, _format_ctx, _stream_index))
+        return false;
+
+    _index = std::move(index);
+    return true;
+}
+
+bool video_capture::load_index(const std::string& index_path)
+{
+    std::lock_guard lock(_open_mutex);
+
+    if(!_is_opened)
+    {
+        log_error("Packet index not available. Video path must be opened first.");
+        return false;
+    }
+
+    if(index_path.empty() && _video_path.empty())
+    {
+        log_error("Packet index path is required for memory inputs");
+        return false;
+    }
+
+    const auto path = index_path.empty() ? packet_index::get_default_path(_video_path) : index_path;
+    auto index = std::make_unique<packet_index>();
+    if (!index->load(path, _format_ctx, _stream_index))
+    {
+        log_error("Unable to load packet index", path);
+        return false;
+    }
+
+    _index = std::move(index);
+    return true;
+}
+
+bool video_capture::is_keyframes_only() const
+{
+    return _keyframes_only;
+}
+
+auto video_capture::get_dropped_frames() const -> std::optional<size_t>
+{
+    if(!_pipeline)
+    {
+        log_error("Dropped frames not available. Decode pipeline must be started first.");
+        return std::nullopt;
+    }
+
+    // Frames discarded by the overflow policy of the output queue of the running pipeline.
+    return std::make_optional(_pipeline->get_dropped_count());
+}
+
+// Lock free snapshot, it can be taken from any thread while frames are being read.
+auto video_capture::get_stats() const -> stats
+{
+    return _stats->get();
+}
+
+void video_capture::reset_stats()
+{
+    _stats->reset();
+}
+
+auto video_capture::get_unused_format_options() const -> options_t
+{
+    return _unused_format_options;
+}
+
+auto video_capture::get_unused_codec_options() const -> options_t
+{
+    return _unused_codec_options;
+}
+
+auto video_capture::get_latency_profile() const -> latency_profile
+{
+    return _latency_profile;
+}
+
+auto video_capture::get_open_time() const -> std::optional<std::chrono::steady_clock::duration>
+{
+    if(!_is_opened)
+    {
+        log_error("Open time not available. Video path must be opened first.");
+        return std::nullopt;
+    }
+
+    return std::make_optional(_open_time);
+}
+
+auto video_capture::get_first_frame_latency() const -> std::optional<std::chrono::steady_clock::duration>
+{
+    if(!_is_opened || _first_frame_latency < 0)
+    {
+        log_error("First frame latency not available. A frame must be decoded first.");
+        return std::nullopt;
+    }
+
+    return std::make_optional(std::chrono::steady_clock::duration(_first_frame_latency.load()));
+}
+
+// Time from the first read to the first decoded frame: demuxer buffering and decoder delay, the open time is reported on its own.
+// Idle time between open() and the first read is left out. Both are written by the reading threads (pipeline or capture group ones).
+void video_capture::set_first_read()
+{
+    if (_first_read < 0)
+        _first_read = std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+void video_capture::set_first_frame_latency()
+{
+    if (_first_frame_latency < 0 && _first_read >= 0)
+        _first_frame_latency = std::chrono::steady_clock::now().time_since_epoch().count() - _first_read;
+}
+
+bool video_capture::has_index() const
+{
+    return _index != nullptr;
+}
+
+bool video_capture::seek_to_pts(int64_t seek_pts, int64_t min_pts, seek_mode mode)
+{
+    if(_pipeline)
+    {
+        log_error("seek() is not available while the decode pipeline is running");
+        return false;
+    }
+
+    // Land on the closest keyframe before the target and drop whatever the decoder still holds from the old position.
+    if (auto r = av_seek_frame(_format_ctx, _stream_index, seek_pts, AVSEEK_FLAG_BACKWARD); r < 0)
+    {
+        log_error("av_seek_frame", vc::logger::get().err2str(r));
+        return false;
+    }
+
+    avcodec_flush_buffers(_codec_ctx);
+    _has_pending_frame = false;
+    _decimation.count = 0;
+    _decimation.next_pts.reset();
+
+    if (mode == seek_mode::fast)
+        return true;
+
+    // Accurate: decode (but do not convert) frames up to the target one, which is kept for the next read().
+    while (grab())
+    {
+        const auto pts = _src_frame->best_effort_timestamp;
+        if (pts == AV_NOPTS_VALUE || pts >= min_pts)
+        {
+            _has_pending_frame = true;
+            return true;
+        }
+    }
+
+    log_error("Unable to seek: end of stream reached before the target position");
+    return false;
+}
+
+double video_capture::get_timestamp(const AVFrame* frame) const
+{
+    const auto time_base = _format_ctx->streams[_stream_index]->time_base;
+    return frame->best_effort_timestamp * static_cast<double>(time_base.num) / static_cast<double>(time_base.den);
+}
+
+bool video_capture::start(size_t queue_size, overflow_policy policy)
+{
+    std::lock_guard lock(_open_mutex);
+
+    if(!_is_opened)
+    {
+        log_error("Decode pipeline not available. Video path must be opened first.");
+        return false;
+    }
+
+    if(_pipeline)
+    {
+        log_error("Decode pipeline is already running");
+        return false;
+    }
+
+    queue_size = std::max<size_t>(queue_size, 1);
+    _pipeline = std::make_unique<pipeline>(*this, queue_size, get_frame_size_in_bytes().value(), policy);
+    _pipeline->start();
+
+    log_info("Decode pipeline started");
     return true;
 }
 
+void video_capture::stop()
+{
+    std::lock_guard lock(_open_mutex);
+
+    if(!_pipeline)
+        return;
+
+    _pipeline.reset();
+
+    // Frames still in flight have been discarded: start over from a clean decoder state.
+    avcodec_flush_buffers(_codec_ctx);
+    log_info("Decode pipeline stopped");
+}
+
+bool video_capture::is_running() const
+{
+    return _pipeline != nullptr;
+}
+
 void video_capture::release()
 {
+    // Errors held back by the rate limiter are reported now, instead of waiting for the next message.
+    vc::logger::get().flush_suppressed();
+
     if(!_is_opened)
         return;
 
     log_info("Release video capture");
+    free_contexts();
+}
+
+void video_capture::free_contexts()
+{
+    _pipeline.reset();
+    _slice_scaler.reset();
+    _index.reset();
 
     if(_sws_ctx)
         sws_freeContext(_sws_ctx);
@@ -390,6 +1558,9 @@ void video_capture::release()
         avformat_free_context(_format_ctx);
     }
 
+    // After the format context: it reads through the memory input until closed.
+    _memory_input.reset();
+
     if (_options)
        av_dict_free(&_options);
 
@@ -425,8 +1596,16 @@ void video_capture::init()
     _tmp_frame = nullptr;
 
     _sws_ctx = nullptr;
+    _scaler_format = AV_PIX_FMT_NONE;
     _options = nullptr;
     _stream_index = -1;
+    _has_pending_frame = false;
+    _video_path.clear();
+    _open_time = {};
+    _first_read = -1;
+    _first_frame_latency = -1;
+    _unused_format_options.clear();
+    _unused_codec_options.clear();
 }
 
 }
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <video_capture/capture_group.hpp>
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstddef>
+
+namespace vc
+{
+class capture_group::work_stealing_pool
+{
+public:
+    using task = std::function<void()>;
+
+    explicit work_stealing_pool(size_t thread_count)
+        : _pending{ 0 }
+        , _sleeping{ 0 }
+        , _stop{ false }
+        , _next_queue{ 0 }
+    {
+        for (size_t i = 0; i < thread_count; ++i)
+            _queues.push_back(std::make_unique<queue>());
+
+        for (size_t i = 0; i < thread_count; ++i)
+            _threads.emplace_back(&work_stealing_pool::worker, this, i);
+    }
+
+    ~work_stealing_pool()
+    {
+        shutdown();
+    }
+
+    // Tasks not started yet are dropped, the running ones are waited for. Tasks submitted from now on are ignored:
+    // the pool stays valid while the running tasks complete, so they can still call submit().
+    void shutdown()
+    {
+        {
+            std::lock_guard lock(_idle_mutex);
+            _stop = true;
+        }
+        _idle_cond.notify_all();
+
+        for (auto& t : _threads)
+            if (t.joinable())
+                t.join();
+    }
+
+    // Workers keep the tasks they submit for themselves (better cache locality), other threads spread them round robin.
+    // Only the queue the task goes to is locked: the idle mutex is taken just to wake up a parked worker, if any.
+    void submit(task t)
+    {
+        if (_stop)
+            return;
+
+        const auto index = _worker_pool == this ? _worker_index : _next_queue++ % _queues.size();
+        {
+            std::lock_guard lock(_queues[index]->mutex);
+            _queues[index]->tasks.push_back(std::move(t));
+        }
+
+        // Pairs with park(): either the parking worker sees the new task, or this sees the worker parked.
+        _pending.fetch_add(1);
+        if (_sleeping.load() > 0)
+        {
+            {
+                std::lock_guard lock(_idle_mutex);
+            }
+            _idle_cond.notify_one();
+        }
+    }
+
+    size_t get_thread_count() const { return _threads.size(); }
+
+private:
+    struct queue
+    {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    void worker(size_t index)
+    {
+        _worker_pool = this;
+        _worker_index = index;
+
+        while (!_stop)
+        {
+            task t;
+            if (!pop(index, t))
+            {
+                park();
+                continue;
+            }
+
+            _pending.fetch_sub(1);
+            t();
+        }
+    }
+
+    // Pending count may be briefly negative (a task popped before its submitter counted it): nothing to wait for then.
+    void park()
+    {
+        std::unique_lock lock(_idle_mutex);
+        _sleeping.fetch_add(1);
+        _idle_cond.wait(lock, [this] { return _stop || _pending.load() > 0; });
+        _sleeping.fetch_sub(1);
+    }
+
+    // Own queue is served in FIFO order, so that every source on it gets its turn.
+    // Idle workers steal from the back of the other queues, away from the owner.
+    bool pop(size_t index, task& t)
+    {
+        for (size_t i = 0; i < _queues.size(); ++i)
+        {
+            auto& q = *_queues[(index + i) % _queues.size()];
+            std::lock_guard lock(q.mutex);
+            if (q.tasks.empty())
+                continue;
+
+            if (i == 0)
+            {
+                t = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+            else
+            {
+                t = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::mutex _idle_mutex;
+    std::condition_variable _idle_cond;
+    std::atomic<std::ptrdiff_t> _pending;
+    std::atomic<size_t> _sleeping;
+    std::atomic<bool> _stop;
+    std::atomic<size_t> _next_queue;
+
+    inline static thread_local const work_stealing_pool* _worker_pool = nullptr;
+    inline static thread_local size_t _worker_index = 0;
+};
+
+}
@@ -0,0 +1,150 @@
+#include "yuv_to_rgb.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace vc
+{
+namespace
+{
+    int clamp_s16(int x) { return std::clamp(x, -32768, 32767); }
+
+    // Scalar equivalent of _mm_mulhrs_epi16: rounded high half of a Q15 product.
+    int mulhrs(int a, int b) { return (a * b + 0x4000) >> 15; }
+
+    template<rgb_layout layout>
+    void store_pixel(uint8_t* dst, int r, int g, int b)
+    {
+        const auto to_u8 = [](int x) { return static_cast<uint8_t>(std::clamp(x >> 6, 0, 255)); };
+        if constexpr (layout == rgb_layout::bgr24)
+        {
+            dst[0] = to_u8(b);
+            dst[1] = to_u8(g);
+            dst[2] = to_u8(r);
+        }
+        else
+        {
+            dst[0] = to_u8(r);
+            dst[1] = to_u8(g);
+            dst[2] = to_u8(b);
+            if constexpr (layout == rgb_layout::rgba)
+                dst[3] = 255;
+        }
+    }
+
+    // Mirrors the saturating 16 bit arithmetic of the SIMD kernels step by step, tails of SIMD rows are handed over to it.
+    template<rgb_layout layout, bool is_nv12>
+    void row_scalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width, const yuv_coefficients& c)
+    {
+        constexpr int bpp = layout == rgb_layout::rgba ? 4 : 3;
+        for (int x = 0; x < width; ++x)
+        {
+            const int cu = is_nv12 ? u[(x / 2) * 2] : u[x / 2];
+            const int cv = is_nv12 ? u[(x / 2) * 2 + 1] : v[x / 2];
+
+            const int yt = mulhrs((y[x] - c.y_offset) * 128, c.y_scale);
+            const int ut = (cu - 128) * 256;
+            const int vt = (cv - 128) * 256;
+
+            const int r = clamp_s16(clamp_s16(yt + mulhrs(vt, c.v_to_r)) + 32);
+            const int g = clamp_s16(clamp_s16(yt - clamp_s16(mulhrs(ut, c.u_to_g) + mulhrs(vt, c.v_to_g))) + 32);
+            const int b = clamp_s16(clamp_s16(yt + mulhrs(ut, c.u_to_b)) + 32);
+            store_pixel<layout>(dst + x * bpp, r, g, b);
+        }
+    }
+}
+
+bool cpu_has_sse41()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("sse4.1");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool cpu_has_avx2()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    // AVX2 needs both the CPU flag and the OS saving YMM registers on context switch.
+    int info[4] = {};
+    __cpuid(info, 1);
+    const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+yuv_coefficients get_yuv_coefficients(yuv_matrix matrix, bool full_range)
+{
+    const double kr = matrix == yuv_matrix::bt709 ? 0.2126 : 0.299;
+    const double kb = matrix == yuv_matrix::bt709 ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+    const double y_scale = full_range ? 1.0 : 255.0 / 219.0;
+    const double c_scale = full_range ? 1.0 : 255.0 / 224.0;
+
+    const auto q = [](double value, int bits) { return static_cast<int16_t>(std::lround(value * (1 << bits))); };
+
+    yuv_coefficients c;
+    c.y_offset = full_range ? 0 : 16;
+    c.y_scale = q(y_scale, 14);
+    c.v_to_r = q(2.0 * (1.0 - kr) * c_scale, 13);
+    c.u_to_g = q(2.0 * (1.0 - kb) * kb / kg * c_scale, 13);
+    c.v_to_g = q(2.0 * (1.0 - kr) * kr / kg * c_scale, 13);
+    c.u_to_b = q(2.0 * (1.0 - kb) * c_scale, 13);
+    return c;
+}
+
+const yuv_kernels& get_yuv_kernels_scalar()
+{
+    static const yuv_kernels kernels
+    {
+        "scalar",
+        { row_scalar<rgb_layout::bgr24, false>, row_scalar<rgb_layout::rgb24, false>, row_scalar<rgb_layout::rgba, false> },
+        { row_scalar<rgb_layout::bgr24, true>, row_scalar<rgb_layout::rgb24, true>, row_scalar<rgb_layout::rgba, true> }
+    };
+    return kernels;
+}
+
+const yuv_kernels& get_yuv_kernels()
+{
+    static const yuv_kernels& kernels = []() -> const yuv_kernels&
+    {
+        if (auto avx2 = get_yuv_kernels_avx2(); avx2 && cpu_has_avx2())
+            return *avx2;
+
+        if (auto sse41 = get_yuv_kernels_sse41(); sse41 && cpu_has_sse41())
+            return *sse41;
+
+        return get_yuv_kernels_scalar();
+    }();
+    return kernels;
+}
+
+void yuv_to_rgb(const uint8_t* const src_data[4], const int src_linesize[4], bool is_nv12, int width, int height,
+    uint8_t* dst, int dst_linesize, rgb_layout layout, const yuv_coefficients& c)
+{
+    const auto& kernels = get_yuv_kernels();
+    const auto row = is_nv12 ? kernels.nv12[static_cast<int>(layout)] : kernels.planar[static_cast<int>(layout)];
+
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* u = src_data[1] + (y / 2) * src_linesize[1];
+        const uint8_t* v = is_nv12 ? nullptr : src_data[2] + (y / 2) * src_linesize[2];
+        row(src_data[0] + y * src_linesize[0], u, v, dst + y * dst_linesize, width, c);
+    }
+}
+
+}
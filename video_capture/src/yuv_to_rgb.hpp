@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vc
+{
+enum class yuv_matrix { bt601, bt709 };
+enum class rgb_layout { bgr24, rgb24, rgba };
+
+// Fixed point conversion coefficients, shared by every kernel so that all of them produce bit-exact results.
+// Luma is scaled in Q14, chroma terms in Q13: both fit a signed 16 bit lane for every supported matrix and range.
+struct yuv_coefficients
+{
+    int16_t y_offset;
+    int16_t y_scale;
+    int16_t v_to_r;
+    int16_t u_to_g;
+    int16_t v_to_g;
+    int16_t u_to_b;
+};
+
+// Converts one row of 4:2:0 pixels. Planar sources pass separate U and V rows, NV12 sources pass the interleaved UV row as u and a null v.
+using yuv_row_kernel = void(*)(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width, const yuv_coefficients& c);
+
+struct yuv_kernels
+{
+    const char* name;
+    yuv_row_kernel planar[3];
+    yuv_row_kernel nv12[3];
+};
+
+yuv_coefficients get_yuv_coefficients(yuv_matrix matrix, bool full_range);
+
+// Best kernel set for the running CPU, detected once on first use.
+const yuv_kernels& get_yuv_kernels();
+const yuv_kernels& get_yuv_kernels_scalar();
+const yuv_kernels* get_yuv_kernels_sse41();
+const yuv_kernels* get_yuv_kernels_avx2();
+
+// The SIMD kernel sets are built on every x86 target, these tell whether the running CPU can execute them.
+bool cpu_has_sse41();
+bool cpu_has_avx2();
+
+void yuv_to_rgb(const uint8_t* const src_data[4], const int src_linesize[4], bool is_nv12, int width, int height,
+    uint8_t* dst, int dst_linesize, rgb_layout layout, const yuv_coefficients& c);
+
+}
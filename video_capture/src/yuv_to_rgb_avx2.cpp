@@ -0,0 +1,127 @@
+#include "yuv_to_rgb.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include "yuv_to_rgb_x86.hpp"
+
+namespace vc
+{
+namespace
+{
+    struct yuv_coefficients_avx2
+    {
+        __m256i y_offset;
+        __m256i y_scale;
+        __m256i v_to_r;
+        __m256i u_to_g;
+        __m256i v_to_g;
+        __m256i u_to_b;
+        __m256i chroma_offset;
+        __m256i round;
+
+        explicit yuv_coefficients_avx2(const yuv_coefficients& c)
+            : y_offset{ _mm256_set1_epi16(c.y_offset) }
+            , y_scale{ _mm256_set1_epi16(c.y_scale) }
+            , v_to_r{ _mm256_set1_epi16(c.v_to_r) }
+            , u_to_g{ _mm256_set1_epi16(c.u_to_g) }
+            , v_to_g{ _mm256_set1_epi16(c.v_to_g) }
+            , u_to_b{ _mm256_set1_epi16(c.u_to_b) }
+            , chroma_offset{ _mm256_set1_epi16(128) }
+            , round{ _mm256_set1_epi16(32) }
+        {
+        }
+    };
+
+    // Same arithmetic as yuv_to_rgb_8(), on 16 pixels.
+    inline void yuv_to_rgb_16(__m256i y, __m256i u, __m256i v, const yuv_coefficients_avx2& c, __m256i& r, __m256i& g, __m256i& b)
+    {
+        y = _mm256_slli_epi16(_mm256_sub_epi16(y, c.y_offset), 7);
+        u = _mm256_slli_epi16(_mm256_sub_epi16(u, c.chroma_offset), 8);
+        v = _mm256_slli_epi16(_mm256_sub_epi16(v, c.chroma_offset), 8);
+
+        const __m256i yt = _mm256_mulhrs_epi16(y, c.y_scale);
+        const __m256i gt = _mm256_adds_epi16(_mm256_mulhrs_epi16(u, c.u_to_g), _mm256_mulhrs_epi16(v, c.v_to_g));
+        r = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(yt, _mm256_mulhrs_epi16(v, c.v_to_r)), c.round), 6);
+        g = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_subs_epi16(yt, gt), c.round), 6);
+        b = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(yt, _mm256_mulhrs_epi16(u, c.u_to_b)), c.round), 6);
+    }
+
+    // packus works within 128 bit lanes: restore pixel order 0-7, 8-15, 16-23, 24-31.
+    inline __m256i pack_32(__m256i lo, __m256i hi)
+    {
+        return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+    }
+
+    template<rgb_layout layout, bool is_nv12>
+    void row_avx2(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width, const yuv_coefficients& c)
+    {
+        constexpr int bpp = layout == rgb_layout::rgba ? 4 : 3;
+        const yuv_coefficients_avx2 cy(c);
+        const yuv_coefficients_x86 cx(c);
+
+        int x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            const __m256i y8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + x));
+
+            __m128i uu, vv;
+            if constexpr (is_nv12)
+            {
+                const __m256i deinterleave = _mm256_setr_epi8(
+                    0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                    0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+                const __m256i uv = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + x)), deinterleave);
+                const __m256i planar = _mm256_permute4x64_epi64(uv, 0xD8);
+                uu = _mm256_castsi256_si128(planar);
+                vv = _mm256_extracti128_si256(planar, 1);
+            }
+            else
+            {
+                uu = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x / 2));
+                vv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x / 2));
+            }
+
+            __m256i r0, g0, b0, r1, g1, b1;
+            yuv_to_rgb_16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(y8)),
+                _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(uu, uu)), _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(vv, vv)), cy, r0, g0, b0);
+            yuv_to_rgb_16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(y8, 1)),
+                _mm256_cvtepu8_epi16(_mm_unpackhi_epi8(uu, uu)), _mm256_cvtepu8_epi16(_mm_unpackhi_epi8(vv, vv)), cy, r1, g1, b1);
+
+            const __m256i r = pack_32(r0, r1);
+            const __m256i g = pack_32(g0, g1);
+            const __m256i b = pack_32(b0, b1);
+            store_16<layout>(dst + x * bpp, _mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b));
+            store_16<layout>(dst + (x + 16) * bpp, _mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1));
+        }
+
+        for (; x + 16 <= width; x += 16)
+            convert_16<layout, is_nv12>(y, u, v, dst, x, cx);
+
+        convert_tail<layout, is_nv12>(y, u, v, dst, x, width, c);
+    }
+}
+
+const yuv_kernels* get_yuv_kernels_avx2()
+{
+    static const yuv_kernels kernels
+    {
+        "avx2",
+        { row_avx2<rgb_layout::bgr24, false>, row_avx2<rgb_layout::rgb24, false>, row_avx2<rgb_layout::rgba, false> },
+        { row_avx2<rgb_layout::bgr24, true>, row_avx2<rgb_layout::rgb24, true>, row_avx2<rgb_layout::rgba, true> }
+    };
+    return &kernels;
+}
+
+}
+
+#else
+
+namespace vc
+{
+const yuv_kernels* get_yuv_kernels_avx2()
+{
+    return nullptr;
+}
+
+}
+
+#endif
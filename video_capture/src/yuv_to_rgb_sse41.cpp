@@ -0,0 +1,47 @@
+#include "yuv_to_rgb.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include "yuv_to_rgb_x86.hpp"
+
+namespace vc
+{
+namespace
+{
+    template<rgb_layout layout, bool is_nv12>
+    void row_sse41(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width, const yuv_coefficients& c)
+    {
+        const yuv_coefficients_x86 cx(c);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+            convert_16<layout, is_nv12>(y, u, v, dst, x, cx);
+
+        convert_tail<layout, is_nv12>(y, u, v, dst, x, width, c);
+    }
+}
+
+const yuv_kernels* get_yuv_kernels_sse41()
+{
+    static const yuv_kernels kernels
+    {
+        "sse4.1",
+        { row_sse41<rgb_layout::bgr24, false>, row_sse41<rgb_layout::rgb24, false>, row_sse41<rgb_layout::rgba, false> },
+        { row_sse41<rgb_layout::bgr24, true>, row_sse41<rgb_layout::rgb24, true>, row_sse41<rgb_layout::rgba, true> }
+    };
+    return &kernels;
+}
+
+}
+
+#else
+
+namespace vc
+{
+const yuv_kernels* get_yuv_kernels_sse41()
+{
+    return nullptr;
+}
+
+}
+
+#endif
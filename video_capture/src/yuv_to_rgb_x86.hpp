@@ -0,0 +1,135 @@
+#pragma once
+
+#include "yuv_to_rgb.hpp"
+
+#include <immintrin.h>
+
+// Included by translation units built with different instruction set flags:
+// everything here has internal linkage so that the linker can never pick e.g. an AVX2 compiled copy for the SSE4.1 kernels.
+namespace vc
+{
+namespace
+{
+    struct yuv_coefficients_x86
+    {
+        __m128i y_offset;
+        __m128i y_scale;
+        __m128i v_to_r;
+        __m128i u_to_g;
+        __m128i v_to_g;
+        __m128i u_to_b;
+        __m128i chroma_offset;
+        __m128i round;
+
+        explicit yuv_coefficients_x86(const yuv_coefficients& c)
+            : y_offset{ _mm_set1_epi16(c.y_offset) }
+            , y_scale{ _mm_set1_epi16(c.y_scale) }
+            , v_to_r{ _mm_set1_epi16(c.v_to_r) }
+            , u_to_g{ _mm_set1_epi16(c.u_to_g) }
+            , v_to_g{ _mm_set1_epi16(c.v_to_g) }
+            , u_to_b{ _mm_set1_epi16(c.u_to_b) }
+            , chroma_offset{ _mm_set1_epi16(128) }
+            , round{ _mm_set1_epi16(32) }
+        {
+        }
+    };
+
+    // 8 pixels, 16 bit lanes in and out (Q6 results, saturated to the int16 range).
+    inline void yuv_to_rgb_8(__m128i y, __m128i u, __m128i v, const yuv_coefficients_x86& c, __m128i& r, __m128i& g, __m128i& b)
+    {
+        y = _mm_slli_epi16(_mm_sub_epi16(y, c.y_offset), 7);
+        u = _mm_slli_epi16(_mm_sub_epi16(u, c.chroma_offset), 8);
+        v = _mm_slli_epi16(_mm_sub_epi16(v, c.chroma_offset), 8);
+
+        const __m128i yt = _mm_mulhrs_epi16(y, c.y_scale);
+        const __m128i gt = _mm_adds_epi16(_mm_mulhrs_epi16(u, c.u_to_g), _mm_mulhrs_epi16(v, c.v_to_g));
+        r = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(yt, _mm_mulhrs_epi16(v, c.v_to_r)), c.round), 6);
+        g = _mm_srai_epi16(_mm_adds_epi16(_mm_subs_epi16(yt, gt), c.round), 6);
+        b = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(yt, _mm_mulhrs_epi16(u, c.u_to_b)), c.round), 6);
+    }
+
+    // Interleaves 16 pixels worth of 8 bit channels into the destination layout.
+    template<rgb_layout layout>
+    inline void store_16(uint8_t* dst, __m128i r, __m128i g, __m128i b)
+    {
+        const __m128i first = layout == rgb_layout::bgr24 ? b : r;
+        const __m128i third = layout == rgb_layout::bgr24 ? r : b;
+        const __m128i alpha = _mm_set1_epi8(-1);
+
+        const __m128i lo_01 = _mm_unpacklo_epi8(first, g);
+        const __m128i hi_01 = _mm_unpackhi_epi8(first, g);
+        const __m128i lo_23 = _mm_unpacklo_epi8(third, alpha);
+        const __m128i hi_23 = _mm_unpackhi_epi8(third, alpha);
+
+        __m128i p0 = _mm_unpacklo_epi16(lo_01, lo_23);
+        __m128i p1 = _mm_unpackhi_epi16(lo_01, lo_23);
+        __m128i p2 = _mm_unpacklo_epi16(hi_01, hi_23);
+        __m128i p3 = _mm_unpackhi_epi16(hi_01, hi_23);
+
+        if constexpr (layout == rgb_layout::rgba)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), p0);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), p1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), p2);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 48), p3);
+        }
+        else
+        {
+            // Drop the alpha byte of every pixel, then stitch the four 12 byte groups into three full registers.
+            const __m128i drop_alpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+            p0 = _mm_shuffle_epi8(p0, drop_alpha);
+            p1 = _mm_shuffle_epi8(p1, drop_alpha);
+            p2 = _mm_shuffle_epi8(p2, drop_alpha);
+            p3 = _mm_shuffle_epi8(p3, drop_alpha);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+        }
+    }
+
+    // 16 pixels starting at x, which must be even.
+    template<rgb_layout layout, bool is_nv12>
+    inline void convert_16(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int x, const yuv_coefficients_x86& c)
+    {
+        constexpr int bpp = layout == rgb_layout::rgba ? 4 : 3;
+        const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+
+        __m128i u8, v8;
+        if constexpr (is_nv12)
+        {
+            const __m128i deinterleave = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+            const __m128i uv = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x)), deinterleave);
+            u8 = _mm_unpacklo_epi8(uv, uv);
+            v8 = _mm_unpackhi_epi8(uv, uv);
+        }
+        else
+        {
+            const __m128i uu = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2));
+            const __m128i vv = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2));
+            u8 = _mm_unpacklo_epi8(uu, uu);
+            v8 = _mm_unpacklo_epi8(vv, vv);
+        }
+
+        __m128i r0, g0, b0, r1, g1, b1;
+        yuv_to_rgb_8(_mm_cvtepu8_epi16(y8), _mm_cvtepu8_epi16(u8), _mm_cvtepu8_epi16(v8), c, r0, g0, b0);
+        yuv_to_rgb_8(_mm_cvtepu8_epi16(_mm_srli_si128(y8, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(u8, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(v8, 8)), c, r1, g1, b1);
+        store_16<layout>(dst + x * bpp, _mm_packus_epi16(r0, r1), _mm_packus_epi16(g0, g1), _mm_packus_epi16(b0, b1));
+    }
+
+    // Remaining pixels of a row (fewer than a full vector) go through the scalar kernel.
+    template<rgb_layout layout, bool is_nv12>
+    inline void convert_tail(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int x, int width, const yuv_coefficients& c)
+    {
+        if (x >= width)
+            return;
+
+        constexpr int bpp = layout == rgb_layout::rgba ? 4 : 3;
+        const auto& scalar = get_yuv_kernels_scalar();
+        if constexpr (is_nv12)
+            scalar.nv12[static_cast<int>(layout)](y + x, u + x, nullptr, dst + x * bpp, width - x, c);
+        else
+            scalar.planar[static_cast<int>(layout)](y + x, u + x / 2, v + x / 2, dst + x * bpp, width - x, c);
+    }
+}
+}
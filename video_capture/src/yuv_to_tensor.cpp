@@ -0,0 +1,131 @@
+#include "yuv_to_tensor.hpp"
+
+#include <algorithm>
+
+namespace vc
+{
+namespace
+{
+    void get_taps(int dst_size, int src_size, int log2_subsampling, std::vector<tensor_tap>& taps)
+    {
+        const int plane_size = (src_size + (1 << log2_subsampling) - 1) >> log2_subsampling;
+        const float ratio = static_cast<float>(src_size) / dst_size;
+        const float subsampling = static_cast<float>(1 << log2_subsampling);
+
+        taps.resize(dst_size);
+        for (int d = 0; d < dst_size; ++d)
+        {
+            const float luma = (d + 0.5f) * ratio - 0.5f;
+            const float s = std::clamp((luma + 0.5f) / subsampling - 0.5f, 0.0f, static_cast<float>(plane_size - 1));
+            taps[d].i0 = static_cast<int>(s);
+            taps[d].i1 = std::min(taps[d].i0 + 1, plane_size - 1);
+            taps[d].w = s - taps[d].i0;
+        }
+    }
+
+    void prepare(const yuv_image& src, const tensor_geometry& geometry, tensor_scratch& scratch)
+    {
+        const std::array<int, 6> key = { src.width, src.height, src.log2_chroma_w, src.log2_chroma_h, geometry.content_width, geometry.content_height };
+        if (key == scratch.key && !scratch.y_row.empty())
+            return;
+
+        get_taps(geometry.content_width, src.width, 0, scratch.x_taps);
+        get_taps(geometry.content_height, src.height, 0, scratch.y_taps);
+        get_taps(geometry.content_width, src.width, src.log2_chroma_w, scratch.cx_taps);
+        get_taps(geometry.content_height, src.height, src.log2_chroma_h, scratch.cy_taps);
+
+        const int chroma_width = (src.width + (1 << src.log2_chroma_w) - 1) >> src.log2_chroma_w;
+        scratch.y_row.resize(src.width);
+        scratch.u_row.resize(chroma_width);
+        scratch.v_row.resize(chroma_width);
+        scratch.key = key;
+    }
+
+    // Vertical interpolation of a whole source row, contiguous and vectorizable: horizontal taps then gather from it.
+    void blend_rows(const uint8_t* r0, const uint8_t* r1, float w, int step, int count, float* out)
+    {
+        for (int i = 0; i < count; ++i)
+            out[i] = r0[i * step] + (r1[i * step] - r0[i * step]) * w;
+    }
+
+    float lerp(const float* row, const tensor_tap& t)
+    {
+        return row[t.i0] + (row[t.i1] - row[t.i0]) * t.w;
+    }
+}
+
+void yuv_to_tensor(const yuv_image& src, float* dst, const tensor_geometry& geometry, bool is_bgr,
+    const yuv_coefficients& c, const tensor_normalization& normalization, tensor_scratch& scratch)
+{
+    const size_t plane_size = static_cast<size_t>(geometry.width) * geometry.height;
+    float* planes[3] = { dst, dst + plane_size, dst + 2 * plane_size };
+
+    // Letterbox bands only: every float of the tensor is written exactly once.
+    const int content_bottom = geometry.content_y + geometry.content_height;
+    const int content_right = geometry.content_x + geometry.content_width;
+    for (int ch = 0; ch < 3; ++ch)
+    {
+        const float pad = normalization.pad[ch];
+        std::fill(planes[ch], planes[ch] + static_cast<size_t>(geometry.content_y) * geometry.width, pad);
+        std::fill(planes[ch] + static_cast<size_t>(content_bottom) * geometry.width, planes[ch] + plane_size, pad);
+        for (int y = geometry.content_y; y < content_bottom; ++y)
+        {
+            float* row = planes[ch] + static_cast<size_t>(y) * geometry.width;
+            std::fill(row, row + geometry.content_x, pad);
+            std::fill(row + content_right, row + geometry.width, pad);
+        }
+    }
+
+    // Same conversion of the fixed point kernels, evaluated in float.
+    const float y_scale = c.y_scale / 16384.0f;
+    const float v_to_r = c.v_to_r / 8192.0f;
+    const float u_to_g = c.u_to_g / 8192.0f;
+    const float v_to_g = c.v_to_g / 8192.0f;
+    const float u_to_b = c.u_to_b / 8192.0f;
+
+    // Tensor channel order: R G B, or B G R.
+    const int r_plane = is_bgr ? 2 : 0;
+    const int b_plane = is_bgr ? 0 : 2;
+
+    prepare(src, geometry, scratch);
+    const auto& x_taps = scratch.x_taps;
+    const auto& y_taps = scratch.y_taps;
+    const auto& cx_taps = scratch.cx_taps;
+    const auto& cy_taps = scratch.cy_taps;
+    auto& y_row = scratch.y_row;
+    auto& u_row = scratch.u_row;
+    auto& v_row = scratch.v_row;
+
+    const int chroma_width = static_cast<int>(u_row.size());
+
+    for (int dy = 0; dy < geometry.content_height; ++dy)
+    {
+        const auto& ty = y_taps[dy];
+        const auto& tc = cy_taps[dy];
+        blend_rows(src.y + ty.i0 * src.y_linesize, src.y + ty.i1 * src.y_linesize, ty.w, 1, src.width, y_row.data());
+        blend_rows(src.u + tc.i0 * src.uv_linesize, src.u + tc.i1 * src.uv_linesize, tc.w, src.uv_step, chroma_width, u_row.data());
+        blend_rows(src.v + tc.i0 * src.uv_linesize, src.v + tc.i1 * src.uv_linesize, tc.w, src.uv_step, chroma_width, v_row.data());
+
+        const size_t offset = static_cast<size_t>(geometry.content_y + dy) * geometry.width + geometry.content_x;
+        float* r_out = planes[r_plane] + offset;
+        float* g_out = planes[1] + offset;
+        float* b_out = planes[b_plane] + offset;
+
+        for (int dx = 0; dx < geometry.content_width; ++dx)
+        {
+            const float yv = (lerp(y_row.data(), x_taps[dx]) - c.y_offset) * y_scale;
+            const float uv = lerp(u_row.data(), cx_taps[dx]) - 128.0f;
+            const float vv = lerp(v_row.data(), cx_taps[dx]) - 128.0f;
+
+            const float r = std::clamp(yv + vv * v_to_r, 0.0f, 255.0f);
+            const float g = std::clamp(yv - uv * u_to_g - vv * v_to_g, 0.0f, 255.0f);
+            const float b = std::clamp(yv + uv * u_to_b, 0.0f, 255.0f);
+
+            r_out[dx] = r * normalization.scale[r_plane] + normalization.offset[r_plane];
+            g_out[dx] = g * normalization.scale[1] + normalization.offset[1];
+            b_out[dx] = b * normalization.scale[b_plane] + normalization.offset[b_plane];
+        }
+    }
+}
+
+}
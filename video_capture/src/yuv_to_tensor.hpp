@@ -0,0 +1,70 @@
+#pragma once
+
+#include "yuv_to_rgb.hpp"
+
+#include <array>
+#include <vector>
+
+namespace vc
+{
+// 8 bit YUV image with any chroma subsampling: planar, or semi planar with interleaved chroma (uv_step 2, e.g. NV12).
+struct yuv_image
+{
+    const uint8_t* y;
+    const uint8_t* u;
+    const uint8_t* v;
+    int y_linesize;
+    int uv_linesize;
+    int uv_step;
+    int log2_chroma_w;
+    int log2_chroma_h;
+    int width;
+    int height;
+};
+
+// Planar float32 (CHW) tensor: the image is resized into the content rectangle, everything else is padding.
+struct tensor_geometry
+{
+    int width;
+    int height;
+    int content_x;
+    int content_y;
+    int content_width;
+    int content_height;
+};
+
+// Per channel affine transform in tensor channel order: value = pixel * scale + offset, pixels in [0, 255].
+struct tensor_normalization
+{
+    float scale[3];
+    float offset[3];
+    float pad[3];
+};
+
+// Bilinear taps of one destination coordinate, pixel centres aligned as in swscale and OpenCV.
+struct tensor_tap
+{
+    int i0;
+    int i1;
+    float w;
+};
+
+// Taps and row buffers of the last geometry: computed on the first frame and reused as long as the source and tensor sizes
+// do not change, so that steady state conversion does not allocate.
+struct tensor_scratch
+{
+    std::array<int, 6> key = {};
+    std::vector<tensor_tap> x_taps;
+    std::vector<tensor_tap> y_taps;
+    std::vector<tensor_tap> cx_taps;
+    std::vector<tensor_tap> cy_taps;
+    std::vector<float> y_row;
+    std::vector<float> u_row;
+    std::vector<float> v_row;
+};
+
+// Colour conversion, bilinear resize, letterbox padding and normalization in a single pass over the YUV planes.
+void yuv_to_tensor(const yuv_image& src, float* dst, const tensor_geometry& geometry, bool is_bgr,
+    const yuv_coefficients& c, const tensor_normalization& normalization, tensor_scratch& scratch);
+
+}